@@ -0,0 +1,417 @@
+// 直接调用 libmmkvc 导出的 C 接口的微基准，不经过 JVM，结果以 JSON 输出到 stdout。
+// 用法：mmkv_bench [--root <dir>] [--quick] [--filter <substring>]
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/aes-cfb.h"
+#include "../src/crc32.h"
+
+using namespace std;
+
+class MMKV;
+
+typedef void (Logger)(int, const char *, const char *);
+
+extern "C" {
+void mmkv_initialize(const char *path, int level, Logger *logger);
+MMKV *mmkv_mmkvWithID(const char *id, int mode, const char *cryptKey, const char *path);
+void mmkv_close(MMKV *mmkv);
+void mmkv_clearAll(MMKV *mmkv);
+void mmkv_trim(MMKV *mmkv);
+long mmkv_count(MMKV *mmkv);
+uint8_t *mmkv_allKeysPacked(MMKV *mmkv, size_t *size);
+const char *mmkv_version();
+size_t mmkv_preload(const char **ids, const int *modes, size_t n, size_t threads, MMKV **out,
+                    void (*callback)(size_t, MMKV *));
+
+int getInt(MMKV *mmkv, const char *key, int defaultValue);
+bool setInt(MMKV *mmkv, const char *key, int value);
+uint32_t getUInt(MMKV *mmkv, const char *key, uint32_t defaultValue);
+bool setUInt(MMKV *mmkv, const char *key, uint32_t value);
+int64_t getLong(MMKV *mmkv, const char *key, int64_t defaultValue);
+bool setLong(MMKV *mmkv, const char *key, int64_t value);
+uint64_t getULong(MMKV *mmkv, const char *key, uint64_t defaultValue);
+bool setULong(MMKV *mmkv, const char *key, uint64_t value);
+float getFloat(MMKV *mmkv, const char *key, float defaultValue);
+bool setFloat(MMKV *mmkv, const char *key, float value);
+double getDouble(MMKV *mmkv, const char *key, double defaultValue);
+bool setDouble(MMKV *mmkv, const char *key, double value);
+bool getBoolean(MMKV *mmkv, const char *key, bool defaultValue);
+bool setBoolean(MMKV *mmkv, const char *key, bool value);
+
+int mmkv_getInt(MMKV *mmkv, const char *key, size_t keySize, int defaultValue);
+bool mmkv_setInt(MMKV *mmkv, const char *key, size_t keySize, int value);
+int64_t mmkv_getLong(MMKV *mmkv, const char *key, size_t keySize, int64_t defaultValue);
+bool mmkv_setLong(MMKV *mmkv, const char *key, size_t keySize, int64_t value);
+
+bool mmkv_setStringWithLength(MMKV *mmkv, const char *key, const char *value, size_t size);
+int64_t mmkv_readValueInto(MMKV *mmkv, const char *key, void *dst, size_t capacity);
+uint8_t *getByteArray(MMKV *mmkv, const char *key, size_t *size);
+bool setByteArray(MMKV *mmkv, const char *key, uint8_t *value, size_t size);
+}
+
+// 与 MMKVMode 一致
+static constexpr int MODE_SINGLE_PROCESS = 1 << 0;
+static constexpr int MODE_MULTI_PROCESS = 1 << 1;
+static constexpr int LOG_LEVEL_NONE = 4;
+static constexpr const char *CRYPT_KEY = "mmkv-bench-key";
+
+struct Instance {
+    const char *mode;
+    int modeValue;
+    bool encrypted;
+};
+
+struct Result {
+    string name;
+    Instance instance;
+    size_t ops;
+    double opsPerSec;
+    uint64_t p50;
+    uint64_t p99;
+};
+
+class Bench {
+public:
+    explicit Bench(string filter) : m_filter(std::move(filter)) {}
+
+    bool wants(const string &name) const {
+        return m_filter.empty() || name.find(m_filter) != string::npos;
+    }
+
+    MMKV *open(const string &name, const Instance &instance) const {
+        const auto id = "bench-" + name + "-" + instance.mode + (instance.encrypted ? "-crypt" : "");
+        const auto mmkv = mmkv_mmkvWithID(id.c_str(), instance.modeValue,
+                                          instance.encrypted ? CRYPT_KEY : nullptr, nullptr);
+        mmkv_clearAll(mmkv);
+        return mmkv;
+    }
+
+    // 逐次计时 ops 次 op(i)，记录吞吐与 p50/p99
+    template<typename F>
+    void run(const string &name, const Instance &instance, const size_t ops, F &&op) {
+        vector<uint64_t> samples(ops);
+        const auto begin = chrono::steady_clock::now();
+        for (size_t i = 0; i < ops; i++) {
+            const auto start = chrono::steady_clock::now();
+            op(i);
+            samples[i] = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        }
+        const auto elapsed = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+        sort(samples.begin(), samples.end());
+        m_results.push_back({
+            name, instance, ops, elapsed > 0 ? ops / elapsed : 0, percentile(samples, 50), percentile(samples, 99)
+        });
+        fprintf(stderr, "%-40s %-6s %-5s %12.0f ops/s\n", name.c_str(), instance.mode,
+                instance.encrypted ? "crypt" : "plain", m_results.back().opsPerSec);
+    }
+
+    void printJson() const {
+        printf("{\n  \"mmkv_version\": \"%s\",\n  \"results\": [\n", mmkv_version());
+        for (size_t i = 0; i < m_results.size(); i++) {
+            const auto &result = m_results[i];
+            printf("    {\"name\": \"%s\", \"mode\": \"%s\", \"encrypted\": %s, \"ops\": %zu, "
+                   "\"ops_per_sec\": %.1f, \"p50_ns\": %llu, \"p99_ns\": %llu}%s\n",
+                   result.name.c_str(), result.instance.mode, result.instance.encrypted ? "true" : "false",
+                   result.ops, result.opsPerSec, static_cast<unsigned long long>(result.p50),
+                   static_cast<unsigned long long>(result.p99), i + 1 < m_results.size() ? "," : "");
+        }
+        printf("  ]\n}\n");
+    }
+
+private:
+    static uint64_t percentile(const vector<uint64_t> &sorted, const size_t percent) {
+        if (sorted.empty()) {
+            return 0;
+        }
+        return sorted[min(sorted.size() - 1, sorted.size() * percent / 100)];
+    }
+
+    const string m_filter;
+    vector<Result> m_results;
+};
+
+static vector<string> makeKeys(const size_t count) {
+    vector<string> keys;
+    keys.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        keys.push_back("bench_key_" + to_string(i));
+    }
+    return keys;
+}
+
+// 定长类型：每种类型先写后读同一批 key
+static void benchPrimitives(Bench &bench, const Instance &instance, const size_t ops) {
+    if (!bench.wants("primitive")) {
+        return;
+    }
+    const auto mmkv = bench.open("primitive", instance);
+    const auto keys = makeKeys(1000);
+    const auto key = [&](const size_t i) { return keys[i % keys.size()].c_str(); };
+
+    bench.run("primitive.setInt", instance, ops, [&](size_t i) { setInt(mmkv, key(i), static_cast<int>(i)); });
+    bench.run("primitive.getInt", instance, ops, [&](size_t i) { getInt(mmkv, key(i), 0); });
+    bench.run("primitive.setUInt", instance, ops, [&](size_t i) { setUInt(mmkv, key(i), static_cast<uint32_t>(i)); });
+    bench.run("primitive.getUInt", instance, ops, [&](size_t i) { getUInt(mmkv, key(i), 0); });
+    bench.run("primitive.setLong", instance, ops, [&](size_t i) { setLong(mmkv, key(i), static_cast<int64_t>(i)); });
+    bench.run("primitive.getLong", instance, ops, [&](size_t i) { getLong(mmkv, key(i), 0); });
+    bench.run("primitive.setULong", instance, ops, [&](size_t i) { setULong(mmkv, key(i), i); });
+    bench.run("primitive.getULong", instance, ops, [&](size_t i) { getULong(mmkv, key(i), 0); });
+    bench.run("primitive.setFloat", instance, ops, [&](size_t i) { setFloat(mmkv, key(i), static_cast<float>(i)); });
+    bench.run("primitive.getFloat", instance, ops, [&](size_t i) { getFloat(mmkv, key(i), 0); });
+    bench.run("primitive.setDouble", instance, ops, [&](size_t i) { setDouble(mmkv, key(i), static_cast<double>(i)); });
+    bench.run("primitive.getDouble", instance, ops, [&](size_t i) { getDouble(mmkv, key(i), 0); });
+    bench.run("primitive.setBoolean", instance, ops, [&](size_t i) { setBoolean(mmkv, key(i), i % 2 == 0); });
+    bench.run("primitive.getBoolean", instance, ops, [&](size_t i) { getBoolean(mmkv, key(i), false); });
+
+    // 带 key 长度的版本，免去 strlen
+    bench.run("primitive.mmkv_setInt", instance, ops, [&](size_t i) {
+        const auto &k = keys[i % keys.size()];
+        mmkv_setInt(mmkv, k.data(), k.size(), static_cast<int>(i));
+    });
+    bench.run("primitive.mmkv_getInt", instance, ops, [&](size_t i) {
+        const auto &k = keys[i % keys.size()];
+        mmkv_getInt(mmkv, k.data(), k.size(), 0);
+    });
+    bench.run("primitive.mmkv_setLong", instance, ops, [&](size_t i) {
+        const auto &k = keys[i % keys.size()];
+        mmkv_setLong(mmkv, k.data(), k.size(), static_cast<int64_t>(i));
+    });
+    bench.run("primitive.mmkv_getLong", instance, ops, [&](size_t i) {
+        const auto &k = keys[i % keys.size()];
+        mmkv_getLong(mmkv, k.data(), k.size(), 0);
+    });
+    mmkv_clearAll(mmkv);
+    mmkv_close(mmkv);
+}
+
+// String/ByteArray：按值大小分别测试，大值减少次数
+static void benchValues(Bench &bench, const Instance &instance, const vector<size_t> &sizes) {
+    if (!bench.wants("value")) {
+        return;
+    }
+    const auto mmkv = bench.open("value", instance);
+    const auto keys = makeKeys(16);
+    for (const auto size: sizes) {
+        const auto ops = clamp<size_t>((64u << 20) / size, 20, 20000);
+        const auto suffix = "." + to_string(size) + "B";
+        string value(size, 'v');
+        vector<uint8_t> bytes(size, 0x5a);
+        vector<uint8_t> buffer(size);
+        const auto key = [&](const size_t i) { return keys[i % keys.size()].c_str(); };
+
+        bench.run("value.setString" + suffix, instance, ops, [&](size_t i) {
+            mmkv_setStringWithLength(mmkv, key(i), value.data(), value.size());
+        });
+        bench.run("value.readStringInto" + suffix, instance, ops, [&](size_t i) {
+            mmkv_readValueInto(mmkv, key(i), buffer.data(), buffer.size());
+        });
+        bench.run("value.setByteArray" + suffix, instance, ops, [&](size_t i) {
+            setByteArray(mmkv, key(i), bytes.data(), bytes.size());
+        });
+        bench.run("value.getByteArray" + suffix, instance, ops, [&](size_t i) {
+            size_t length = 0;
+            free(getByteArray(mmkv, key(i), &length));
+        });
+        mmkv_clearAll(mmkv);
+    }
+    mmkv_close(mmkv);
+}
+
+// 不同 key 数量下的写入、随机读取、allKeys、trim、clearAll 与冷启动
+static void benchKeyCounts(Bench &bench, const Instance &instance, const vector<size_t> &counts) {
+    if (!bench.wants("keys")) {
+        return;
+    }
+    mt19937_64 random(42);
+    for (const auto count: counts) {
+        const auto suffix = "." + to_string(count);
+        const auto keys = makeKeys(count);
+        auto mmkv = bench.open("keys" + suffix, instance);
+
+        bench.run("keys.fill" + suffix, instance, count, [&](size_t i) { setInt(mmkv, keys[i].c_str(), static_cast<int>(i)); });
+        const auto reads = min<size_t>(count, 100000);
+        bench.run("keys.randomGet" + suffix, instance, reads, [&](size_t) {
+            getInt(mmkv, keys[random() % count].c_str(), 0);
+        });
+        bench.run("keys.allKeys" + suffix, instance, 5, [&](size_t) {
+            size_t size = 0;
+            free(mmkv_allKeysPacked(mmkv, &size));
+        });
+
+        // 关闭后重新打开并读取一个值，包含加载文件与建立索引
+        bench.run("keys.coldOpen" + suffix, instance, 1, [&](size_t) {
+            mmkv_close(mmkv);
+            const auto id = "bench-keys" + suffix + "-" + instance.mode + (instance.encrypted ? "-crypt" : "");
+            mmkv = mmkv_mmkvWithID(id.c_str(), instance.modeValue, instance.encrypted ? CRYPT_KEY : nullptr,
+                                   nullptr);
+            getInt(mmkv, keys[0].c_str(), 0);
+        });
+        bench.run("keys.clearAll" + suffix, instance, 1, [&](size_t) { mmkv_clearAll(mmkv); });
+        bench.run("keys.trim" + suffix, instance, 1, [&](size_t) { mmkv_trim(mmkv); });
+        if (mmkv_count(mmkv) != 0) {
+            fprintf(stderr, "keys%s: clearAll left %ld keys\n", suffix.c_str(), mmkv_count(mmkv));
+        }
+        mmkv_close(mmkv);
+    }
+}
+
+// 不同数据量下的 CRC32：运行时选择的实现与查表实现对比，MMKV 加载与跨进程重新加载时对整个已用区域计算 CRC
+static void benchCrc32(Bench &bench, const vector<size_t> &sizes) {
+    if (!bench.wants("crc32")) {
+        return;
+    }
+    const Instance none = {"none", 0, false};
+    mt19937_64 random(42);
+    vector<uint8_t> data(sizes.empty() ? 0 : *max_element(sizes.begin(), sizes.end()));
+    for (auto &byte: data) {
+        byte = static_cast<uint8_t>(random());
+    }
+    uint32_t sink = 0;
+    for (const auto size: sizes) {
+        const auto ops = max<size_t>(4, (256 << 20) / size);
+        const auto suffix = "." + to_string(size);
+        bench.run("crc32." + string(crc32Implementation()) + suffix, none, ops, [&](size_t) {
+            sink ^= crc32Dispatch(0, data.data(), size);
+        });
+        bench.run("crc32.portable" + suffix, none, ops, [&](size_t) {
+            sink ^= crc32Portable(0, data.data(), size);
+        });
+    }
+    fprintf(stderr, "crc32 sink %08x\n", sink);
+}
+
+// AES-128 CFB 加解密吞吐：运行时选择的实现与查表实现对比，加密实例与明文实例的整体对比见其余各项的 crypt 结果
+static void benchCrypt(Bench &bench, const vector<size_t> &sizes) {
+    if (!bench.wants("crypt")) {
+        return;
+    }
+    const Instance none = {"none", 0, false};
+    mt19937_64 random(42);
+    vector<uint8_t> input(sizes.empty() ? 0 : *max_element(sizes.begin(), sizes.end()));
+    for (auto &byte: input) {
+        byte = static_cast<uint8_t>(random());
+    }
+    vector<uint8_t> output(input.size());
+    const auto keyLength = strlen(CRYPT_KEY);
+    for (const auto portable: {false, true}) {
+        const string name = portable ? "portable" : AesCfb128::implementation();
+        for (const auto size: sizes) {
+            const auto ops = max<size_t>(4, (64 << 20) / size);
+            const auto suffix = "." + to_string(size);
+            bench.run("crypt." + name + ".encrypt" + suffix, none, ops, [&](size_t) {
+                AesCfb128 crypt(CRYPT_KEY, keyLength, CRYPT_KEY, keyLength);
+                if (portable) {
+                    crypt.usePortable();
+                }
+                crypt.encrypt(input.data(), output.data(), size);
+            });
+            bench.run("crypt." + name + ".decrypt" + suffix, none, ops, [&](size_t) {
+                AesCfb128 crypt(CRYPT_KEY, keyLength, CRYPT_KEY, keyLength);
+                if (portable) {
+                    crypt.usePortable();
+                }
+                crypt.decrypt(input.data(), output.data(), size);
+            });
+        }
+    }
+}
+
+// 启动时打开多个实例：逐个 mmkv_mmkvWithID 与 mmkv_preload 对比，mmkv_preload 不支持加密实例
+static void benchPreload(Bench &bench, const Instance &instance, const size_t instances, const size_t keys) {
+    if (!bench.wants("preload") || instance.encrypted) {
+        return;
+    }
+    vector<string> ids;
+    for (size_t i = 0; i < instances; i++) {
+        ids.push_back("bench-preload-" + to_string(i) + "-" + instance.mode);
+    }
+    const auto keyNames = makeKeys(keys);
+    const auto openAll = [&] {
+        vector<MMKV *> handles;
+        for (const auto &id: ids) {
+            handles.push_back(mmkv_mmkvWithID(id.c_str(), instance.modeValue, nullptr, nullptr));
+        }
+        return handles;
+    };
+    for (const auto mmkv: openAll()) {
+        for (size_t i = 0; i < keys; i++) {
+            setInt(mmkv, keyNames[i].c_str(), static_cast<int>(i));
+        }
+        mmkv_close(mmkv);
+    }
+    const auto closeAll = [](const vector<MMKV *> &handles) {
+        for (const auto mmkv: handles) {
+            if (mmkv != nullptr) {
+                mmkv_close(mmkv);
+            }
+        }
+    };
+    const auto suffix = "." + to_string(instances);
+    bench.run("preload.serial" + suffix, instance, 1, [&](size_t) { closeAll(openAll()); });
+    vector<const char *> cIds;
+    for (const auto &id: ids) {
+        cIds.push_back(id.c_str());
+    }
+    const vector<int> modes(instances, instance.modeValue);
+    vector<MMKV *> handles(instances);
+    bench.run("preload.parallel" + suffix, instance, 1, [&](size_t) {
+        mmkv_preload(cIds.data(), modes.data(), instances, 0, handles.data(), nullptr);
+        closeAll(handles);
+    });
+}
+
+int main(const int argc, char **argv) {
+    string root = (filesystem::temp_directory_path() / "mmkv-bench").string();
+    string filter;
+    bool quick = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--root") == 0 && i + 1 < argc) {
+            root = argv[++i];
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--quick") == 0) {
+            quick = true;
+        } else {
+            fprintf(stderr, "usage: %s [--root <dir>] [--quick] [--filter <substring>]\n", argv[0]);
+            return 1;
+        }
+    }
+    filesystem::remove_all(root);
+    mmkv_initialize(root.c_str(), LOG_LEVEL_NONE, nullptr);
+
+    const vector<Instance> instances = {
+        {"single", MODE_SINGLE_PROCESS, false},
+        {"single", MODE_SINGLE_PROCESS, true},
+        {"multi", MODE_MULTI_PROCESS, false},
+        {"multi", MODE_MULTI_PROCESS, true},
+    };
+    const vector<size_t> sizes = quick
+        ? vector<size_t>{8, 512, 64 << 10}
+        : vector<size_t>{8, 64, 512, 4 << 10, 64 << 10, 1 << 20, 4 << 20};
+    const vector<size_t> counts = quick ? vector<size_t>{100, 10000} : vector<size_t>{100, 10000, 100000, 1000000};
+    const size_t ops = quick ? 20000 : 200000;
+
+    Bench bench(filter);
+    const vector<size_t> crcSizes = quick
+        ? vector<size_t>{4 << 10, 1 << 20, 64 << 20}
+        : vector<size_t>{4 << 10, 64 << 10, 1 << 20, 16 << 20, 128 << 20, 512 << 20};
+    benchCrc32(bench, crcSizes);
+    benchCrypt(bench, quick ? vector<size_t>{4 << 10, 1 << 20} : vector<size_t>{4 << 10, 64 << 10, 1 << 20, 16 << 20});
+    for (const auto &instance: instances) {
+        benchPrimitives(bench, instance, ops);
+        benchValues(bench, instance, sizes);
+        benchKeyCounts(bench, instance, counts);
+        benchPreload(bench, instance, 40, quick ? 1000 : 100000);
+    }
+    bench.printJson();
+    return 0;
+}
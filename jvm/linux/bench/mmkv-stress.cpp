@@ -0,0 +1,327 @@
+// 多进程竞争压测：fork 出 N 个写进程与 M 个读进程，以多进程模式打开同一个 mmkv_mmkvWithID 实例，
+// 统计总吞吐、跨进程锁的等待/持有时间分布与重新加载次数，结束后校验数据一致性，结果以 JSON 输出到 stdout。
+// 用法：mmkv_stress [--root <dir>] [--writers N] [--readers M] [--seconds S] [--keys K] [--batch B]
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+class MMKV;
+
+typedef void (Logger)(int, const char *, const char *);
+
+static constexpr size_t LATENCY_BUCKETS = 32;
+
+// 与 native-binding-linux.cpp 中的 MMKVStats 保持一致
+struct MMKVStats {
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t bytesAppended;
+    uint64_t fullWritebacks;
+    uint64_t fileExpansions;
+    uint64_t trims;
+    uint64_t reloads;
+    uint64_t crcFailures;
+    uint64_t lockWaitNanos;
+    uint64_t getLatency[LATENCY_BUCKETS];
+    uint64_t setLatency[LATENCY_BUCKETS];
+};
+
+extern "C" {
+void mmkv_initialize(const char *path, int level, Logger *logger);
+MMKV *mmkv_mmkvWithID(const char *id, int mode, const char *cryptKey, const char *path);
+void mmkv_close(MMKV *mmkv);
+long mmkv_count(MMKV *mmkv);
+int64_t getLong(MMKV *mmkv, const char *key, int64_t defaultValue);
+int64_t mmkv_setBatch(MMKV *mmkv, const uint8_t *records, size_t size, size_t count);
+void mmkv_enableStats(MMKV *mmkv, bool enable);
+bool mmkv_stats(MMKV *mmkv, MMKVStats *out);
+}
+
+// 与 MMKVMode / NativeValueType 一致
+static constexpr int MODE_MULTI_PROCESS = 1 << 1;
+static constexpr uint32_t TYPE_LONG = 3;
+static constexpr int LOG_LEVEL_NONE = 4;
+static constexpr const char *MMAP_ID = "mmkv-stress";
+
+// 需要注册 handler 才能收到其他进程修改后重新加载的回调，日志本身全部丢弃
+static void discardLog(int, const char *, const char *) {}
+
+static string keyOf(const size_t writer, const size_t key) {
+    return "w" + to_string(writer) + "_k" + to_string(key);
+}
+
+// 按 2 的幂分桶的耗时直方图，第 i 桶为 [2^i, 2^(i+1)) 纳秒
+struct Histogram {
+    uint64_t buckets[LATENCY_BUCKETS];
+    uint64_t max;
+
+    void add(const uint64_t nanos) {
+        size_t bucket = 0;
+        for (auto value = nanos; value > 1 && bucket < LATENCY_BUCKETS - 1; value >>= 1) {
+            bucket++;
+        }
+        buckets[bucket]++;
+        max = std::max(max, nanos);
+    }
+
+    void merge(const Histogram &other) {
+        for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+            buckets[i] += other.buckets[i];
+        }
+        max = std::max(max, other.max);
+    }
+
+    // 返回所在桶的上界
+    uint64_t percentile(const double percent) const {
+        uint64_t total = 0;
+        for (const auto count: buckets) {
+            total += count;
+        }
+        if (total == 0) {
+            return 0;
+        }
+        const auto target = std::max<uint64_t>(1, static_cast<uint64_t>(total * percent / 100));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+            seen += buckets[i];
+            if (seen >= target) {
+                return std::min<uint64_t>(uint64_t(1) << (i + 1), max);
+            }
+        }
+        return max;
+    }
+};
+
+// 子进程通过管道交给父进程的结果，只含定长字段
+struct WorkerReport {
+    uint64_t ops;
+    uint64_t lastSequence; // 写进程写入的最后一个序号
+    uint64_t violations;   // 读进程观察到的值回退或值与 key 不符的次数
+    uint64_t reloads;
+    Histogram latency;
+    Histogram lockWait;
+    Histogram lockHold;
+};
+
+static uint64_t nanosSince(const chrono::steady_clock::time_point start) {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+}
+
+// 写进程：第 s 次写入 key (s % keys)，值为 s，每次以 mmkv_setBatch 在一次跨进程锁内写入 batch 条
+static WorkerReport runWriter(MMKV *mmkv, const size_t writer, const size_t keys, const size_t batch,
+                              const chrono::steady_clock::time_point deadline) {
+    WorkerReport report{};
+    vector<uint8_t> records;
+    uint64_t sequence = 0;
+    while (chrono::steady_clock::now() < deadline) {
+        records.clear();
+        for (size_t i = 0; i < batch; i++) {
+            sequence++;
+            const auto key = keyOf(writer, sequence % keys);
+            const uint32_t header[2] = {TYPE_LONG, static_cast<uint32_t>(key.size())};
+            const auto offset = records.size();
+            records.resize(offset + ((sizeof(header) + sizeof(sequence) + key.size() + 7) & ~size_t(7)));
+            memcpy(records.data() + offset, header, sizeof(header));
+            memcpy(records.data() + offset + sizeof(header), &sequence, sizeof(sequence));
+            memcpy(records.data() + offset + sizeof(header) + sizeof(sequence), key.data(), key.size());
+        }
+        MMKVStats before{}, after{};
+        mmkv_stats(mmkv, &before);
+        const auto start = chrono::steady_clock::now();
+        mmkv_setBatch(mmkv, records.data(), records.size(), batch);
+        const auto elapsed = nanosSince(start);
+        mmkv_stats(mmkv, &after);
+        const auto wait = after.lockWaitNanos - before.lockWaitNanos;
+        report.latency.add(elapsed);
+        report.lockWait.add(wait);
+        report.lockHold.add(elapsed > wait ? elapsed - wait : 0);
+        report.ops += batch;
+    }
+    report.lastSequence = sequence;
+    return report;
+}
+
+// 读进程：随机读取，同一 key 的值不应回退，且值对 keys 取模应等于 key 的序号
+static WorkerReport runReader(MMKV *mmkv, const size_t writers, const size_t keys, const size_t seed,
+                              const chrono::steady_clock::time_point deadline) {
+    WorkerReport report{};
+    mt19937_64 random(seed);
+    vector<int64_t> lastSeen(writers * keys, 0);
+    vector<string> names;
+    names.reserve(writers * keys);
+    for (size_t writer = 0; writer < writers; writer++) {
+        for (size_t key = 0; key < keys; key++) {
+            names.push_back(keyOf(writer, key));
+        }
+    }
+    while (chrono::steady_clock::now() < deadline) {
+        const auto index = random() % names.size();
+        const auto start = chrono::steady_clock::now();
+        const auto value = getLong(mmkv, names[index].c_str(), 0);
+        report.latency.add(nanosSince(start));
+        report.ops++;
+        if (value < lastSeen[index] || (value != 0 && static_cast<size_t>(value) % keys != index % keys)) {
+            report.violations++;
+        }
+        lastSeen[index] = max(lastSeen[index], value);
+    }
+    return report;
+}
+
+static void printHistogram(const char *name, const Histogram &histogram, const bool last = false) {
+    printf("  \"%s\": {\"p50_ns\": %llu, \"p99_ns\": %llu, \"max_ns\": %llu}%s\n", name,
+           static_cast<unsigned long long>(histogram.percentile(50)),
+           static_cast<unsigned long long>(histogram.percentile(99)),
+           static_cast<unsigned long long>(histogram.max), last ? "" : ",");
+}
+
+int main(const int argc, char **argv) {
+    string root = (filesystem::temp_directory_path() / "mmkv-stress").string();
+    size_t writers = 4, readers = 4, keys = 1000, batch = 1;
+    double seconds = 5;
+    for (int i = 1; i < argc; i++) {
+        const auto option = string(argv[i]);
+        if (i + 1 >= argc) {
+            fprintf(stderr, "missing value for %s\n", option.c_str());
+            return 1;
+        }
+        const auto value = argv[++i];
+        if (option == "--root") {
+            root = value;
+        } else if (option == "--writers") {
+            writers = strtoul(value, nullptr, 10);
+        } else if (option == "--readers") {
+            readers = strtoul(value, nullptr, 10);
+        } else if (option == "--seconds") {
+            seconds = strtod(value, nullptr);
+        } else if (option == "--keys") {
+            keys = max<size_t>(1, strtoul(value, nullptr, 10));
+        } else if (option == "--batch") {
+            batch = max<size_t>(1, strtoul(value, nullptr, 10));
+        } else {
+            fprintf(stderr, "usage: %s [--root <dir>] [--writers N] [--readers M] [--seconds S] [--keys K] "
+                            "[--batch B]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (writers == 0) {
+        fprintf(stderr, "--writers must be at least 1\n");
+        return 1;
+    }
+    filesystem::remove_all(root);
+    filesystem::create_directories(root);
+
+    // 父进程在所有子进程结束前不初始化 MMKV，fork 之后各自初始化
+    struct Worker {
+        pid_t pid;
+        int fd;
+        bool writer;
+        size_t index;
+    };
+    vector<Worker> workers;
+    const auto deadline = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(
+                              chrono::duration<double>(seconds));
+    for (size_t i = 0; i < writers + readers; i++) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            perror("pipe");
+            return 1;
+        }
+        const bool writer = i < writers;
+        const auto index = writer ? i : i - writers;
+        const auto pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return 1;
+        }
+        if (pid == 0) {
+            close(fds[0]);
+            mmkv_initialize(root.c_str(), LOG_LEVEL_NONE, discardLog);
+            const auto mmkv = mmkv_mmkvWithID(MMAP_ID, MODE_MULTI_PROCESS, nullptr, nullptr);
+            mmkv_enableStats(mmkv, true);
+            auto report = writer
+                ? runWriter(mmkv, index, keys, batch, deadline)
+                : runReader(mmkv, writers, keys, index + 1, deadline);
+            MMKVStats stats{};
+            mmkv_stats(mmkv, &stats);
+            report.reloads = stats.reloads;
+            const auto written = write(fds[1], &report, sizeof(report));
+            close(fds[1]);
+            _exit(written == static_cast<ssize_t>(sizeof(report)) ? 0 : 1);
+        }
+        close(fds[1]);
+        workers.push_back({pid, fds[0], writer, index});
+    }
+
+    WorkerReport writeTotal{}, readTotal{};
+    vector<uint64_t> lastSequences(writers, 0);
+    bool failed = false;
+    for (const auto &worker: workers) {
+        WorkerReport report{};
+        const auto got = read(worker.fd, &report, sizeof(report));
+        close(worker.fd);
+        int status = 0;
+        waitpid(worker.pid, &status, 0);
+        if (got != static_cast<ssize_t>(sizeof(report)) || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "%s %zu failed\n", worker.writer ? "writer" : "reader", worker.index);
+            failed = true;
+            continue;
+        }
+        auto &total = worker.writer ? writeTotal : readTotal;
+        total.ops += report.ops;
+        total.violations += report.violations;
+        total.reloads += report.reloads;
+        total.latency.merge(report.latency);
+        total.lockWait.merge(report.lockWait);
+        total.lockHold.merge(report.lockHold);
+        if (worker.writer) {
+            lastSequences[worker.index] = report.lastSequence;
+        }
+    }
+
+    // 所有进程结束后，每个 key 应为对应写进程最后一次写入它的序号
+    mmkv_initialize(root.c_str(), LOG_LEVEL_NONE, nullptr);
+    const auto mmkv = mmkv_mmkvWithID(MMAP_ID, MODE_MULTI_PROCESS, nullptr, nullptr);
+    uint64_t mismatches = 0;
+    for (size_t writer = 0; writer < writers; writer++) {
+        const auto last = lastSequences[writer];
+        for (size_t key = 0; key < keys; key++) {
+            // 不大于 last 且对 keys 取模为 key 的最大序号，没有写入过时为 0
+            const uint64_t expected = last >= key ? last - (last - key) % keys : 0;
+            if (static_cast<uint64_t>(getLong(mmkv, keyOf(writer, key).c_str(), 0)) != expected) {
+                mismatches++;
+            }
+        }
+    }
+    const auto consistent = !failed && mismatches == 0 && readTotal.violations == 0;
+
+    printf("{\n");
+    printf("  \"writers\": %zu, \"readers\": %zu, \"seconds\": %.1f, \"keys\": %zu, \"batch\": %zu,\n",
+           writers, readers, seconds, keys, batch);
+    printf("  \"write_ops_per_sec\": %.1f, \"read_ops_per_sec\": %.1f,\n",
+           writeTotal.ops / seconds, readTotal.ops / seconds);
+    printf("  \"reloads\": %llu, \"reloads_per_sec\": %.1f,\n",
+           static_cast<unsigned long long>(writeTotal.reloads + readTotal.reloads),
+           (writeTotal.reloads + readTotal.reloads) / seconds);
+    printHistogram("write_batch_latency", writeTotal.latency);
+    printHistogram("read_latency", readTotal.latency);
+    printHistogram("lock_wait", writeTotal.lockWait);
+    printHistogram("lock_hold", writeTotal.lockHold);
+    printf("  \"final_key_count\": %ld, \"final_mismatches\": %llu, \"read_violations\": %llu,\n",
+           mmkv_count(mmkv), static_cast<unsigned long long>(mismatches),
+           static_cast<unsigned long long>(readTotal.violations));
+    printf("  \"consistent\": %s\n}\n", consistent ? "true" : "false");
+    mmkv_close(mmkv);
+    return consistent ? 0 : 2;
+}
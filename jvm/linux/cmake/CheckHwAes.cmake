@@ -0,0 +1,25 @@
+# 构建后检查 MMKV_HW_AES 的替换确实生效：libmmkvc 中的 openssl::AES_set_encrypt_key 与 AES_cfb128_encrypt
+# 只能来自 aes-cfb.cpp，MMKV 的查表实现（以 openssl::AES_encrypt 为标志）不应被链入。
+# MMKV 调整 libmmkv.a 的目标文件划分后，替换可能静默失效或只替换一半，此时让构建失败。
+# 用法：cmake -DNM=<nm> -DLIBRARY=<libmmkvc.so> -P CheckHwAes.cmake
+execute_process(
+        COMMAND ${NM} --demangle ${LIBRARY}
+        OUTPUT_VARIABLE symbols
+        RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "MMKV_HW_AES: failed to list the symbols of ${LIBRARY}")
+endif ()
+
+foreach (function AES_set_encrypt_key AES_cfb128_encrypt)
+    string(REGEX MATCHALL "[0-9a-f]+ [Tt] openssl::${function}\\(" definitions "${symbols}")
+    list(LENGTH definitions count)
+    if (NOT count EQUAL 1)
+        message(FATAL_ERROR "MMKV_HW_AES: expected one definition of openssl::${function} in ${LIBRARY}, "
+                "found ${count}; turn MMKV_HW_AES off or update src/aes-cfb.cpp for this MMKV version")
+    endif ()
+endforeach ()
+
+if (symbols MATCHES "[0-9a-f]+ [Tt] openssl::AES_encrypt\\(")
+    message(FATAL_ERROR "MMKV_HW_AES: MMKV's own AES implementation is still linked into ${LIBRARY}; "
+            "turn MMKV_HW_AES off or update src/aes-cfb.cpp for this MMKV version")
+endif ()
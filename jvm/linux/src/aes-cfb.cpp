@@ -0,0 +1,377 @@
+#include "aes-cfb.h"
+
+#if defined(MMKV_HW_AES) && defined(__x86_64__)
+#include "MMKV/aes/openssl/openssl_aes.h"
+#include <type_traits>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+using RoundKeys = uint8_t[11][AesCfb128::BLOCK_SIZE];
+
+struct AesCfb128::Implementation {
+    // 原地加密一个块
+    void (*encryptBlock)(const RoundKeys &roundKeys, uint8_t *block);
+    // 从块边界开始加密 blocks 个完整块并更新 vector，CFB 加密时每块依赖上一块的密文，只能串行
+    void (*encryptBlocks)(const RoundKeys &roundKeys, uint8_t *vector, const uint8_t *in, uint8_t *out, size_t blocks);
+    // 从块边界开始解密 blocks 个完整块并更新 vector，CFB 解密时各块的 AES 相互独立，可以流水处理
+    void (*decryptBlocks)(const RoundKeys &roundKeys, uint8_t *vector, const uint8_t *in, uint8_t *out, size_t blocks);
+    const char *name;
+};
+
+namespace {
+
+constexpr size_t BLOCK_SIZE = AesCfb128::BLOCK_SIZE;
+
+uint8_t rotl8(const uint8_t x, const int shift) {
+    return static_cast<uint8_t>((x << shift) | (x >> (8 - shift)));
+}
+
+// 按 GF(2^8) 求逆再做仿射变换生成 S 盒，免去手抄 256 项常量
+std::array<uint8_t, 256> makeSBox() {
+    std::array<uint8_t, 256> sbox{};
+    uint8_t p = 1, q = 1;
+    do {
+        p = static_cast<uint8_t>(p ^ (p << 1) ^ (p & 0x80 ? 0x1b : 0));
+        q ^= static_cast<uint8_t>(q << 1);
+        q ^= static_cast<uint8_t>(q << 2);
+        q ^= static_cast<uint8_t>(q << 4);
+        if (q & 0x80) {
+            q ^= 0x09;
+        }
+        sbox[p] = static_cast<uint8_t>(q ^ rotl8(q, 1) ^ rotl8(q, 2) ^ rotl8(q, 3) ^ rotl8(q, 4) ^ 0x63);
+    } while (p != 1);
+    sbox[0] = 0x63;
+    return sbox;
+}
+
+const std::array<uint8_t, 256> &sbox() {
+    static const auto table = makeSBox();
+    return table;
+}
+
+uint8_t xtime(const uint8_t x) {
+    return static_cast<uint8_t>((x << 1) ^ (x & 0x80 ? 0x1b : 0));
+}
+
+// FIPS-197 的 AES-128 密钥扩展，各实现共用，轮密钥按字节顺序存放
+void expandKey(const uint8_t *key, RoundKeys &roundKeys) {
+    const auto &s = sbox();
+    memcpy(roundKeys[0], key, BLOCK_SIZE);
+    uint8_t rcon = 1;
+    for (size_t round = 1; round <= 10; round++) {
+        const uint8_t *prev = roundKeys[round - 1];
+        uint8_t *next = roundKeys[round];
+        next[0] = prev[0] ^ s[prev[13]] ^ rcon;
+        next[1] = prev[1] ^ s[prev[14]];
+        next[2] = prev[2] ^ s[prev[15]];
+        next[3] = prev[3] ^ s[prev[12]];
+        for (size_t i = 4; i < BLOCK_SIZE; i++) {
+            next[i] = prev[i] ^ next[i - 4];
+        }
+        rcon = xtime(rcon);
+    }
+}
+
+void encryptBlockPortable(const RoundKeys &roundKeys, uint8_t *block) {
+    const auto &s = sbox();
+    uint8_t state[BLOCK_SIZE];
+    for (size_t i = 0; i < BLOCK_SIZE; i++) {
+        state[i] = block[i] ^ roundKeys[0][i];
+    }
+    for (size_t round = 1; round <= 10; round++) {
+        // SubBytes 与 ShiftRows：第 r 行循环左移 r 个字节
+        uint8_t shifted[BLOCK_SIZE];
+        for (size_t column = 0; column < 4; column++) {
+            for (size_t row = 0; row < 4; row++) {
+                shifted[row + 4 * column] = s[state[row + 4 * ((column + row) % 4)]];
+            }
+        }
+        if (round == 10) {
+            memcpy(state, shifted, BLOCK_SIZE);
+        } else {
+            for (size_t column = 0; column < 4; column++) {
+                const uint8_t *a = shifted + 4 * column;
+                const uint8_t all = a[0] ^ a[1] ^ a[2] ^ a[3];
+                for (size_t row = 0; row < 4; row++) {
+                    state[4 * column + row] = a[row] ^ all ^ xtime(a[row] ^ a[(row + 1) % 4]);
+                }
+            }
+        }
+        for (size_t i = 0; i < BLOCK_SIZE; i++) {
+            state[i] ^= roundKeys[round][i];
+        }
+    }
+    memcpy(block, state, BLOCK_SIZE);
+}
+
+template<void (*EncryptBlock)(const RoundKeys &, uint8_t *)>
+void encryptBlocksSerial(const RoundKeys &roundKeys, uint8_t *vector, const uint8_t *in, uint8_t *out,
+                         size_t blocks) {
+    for (; blocks > 0; blocks--, in += BLOCK_SIZE, out += BLOCK_SIZE) {
+        EncryptBlock(roundKeys, vector);
+        for (size_t i = 0; i < BLOCK_SIZE; i++) {
+            vector[i] ^= in[i];
+            out[i] = vector[i];
+        }
+    }
+}
+
+template<void (*EncryptBlock)(const RoundKeys &, uint8_t *)>
+void decryptBlocksSerial(const RoundKeys &roundKeys, uint8_t *vector, const uint8_t *in, uint8_t *out,
+                         size_t blocks) {
+    for (; blocks > 0; blocks--, in += BLOCK_SIZE, out += BLOCK_SIZE) {
+        EncryptBlock(roundKeys, vector);
+        for (size_t i = 0; i < BLOCK_SIZE; i++) {
+            const uint8_t cipher = in[i];
+            out[i] = vector[i] ^ cipher;
+            vector[i] = cipher;
+        }
+    }
+}
+
+const AesCfb128::Implementation PORTABLE = {
+    encryptBlockPortable,
+    encryptBlocksSerial<encryptBlockPortable>,
+    decryptBlocksSerial<encryptBlockPortable>,
+    "portable"
+};
+
+#if defined(__x86_64__)
+
+__attribute__((target("aes,sse2")))
+void encryptBlockAesni(const RoundKeys &roundKeys, uint8_t *block) {
+    const auto key = [&roundKeys](const size_t round) {
+        return _mm_load_si128(reinterpret_cast<const __m128i *>(roundKeys[round]));
+    };
+    __m128i state = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(block)), key(0));
+    for (size_t round = 1; round < 10; round++) {
+        state = _mm_aesenc_si128(state, key(round));
+    }
+    state = _mm_aesenclast_si128(state, key(10));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(block), state);
+}
+
+// 反馈向量全程留在寄存器中
+__attribute__((target("aes,sse2")))
+void encryptBlocksAesni(const RoundKeys &roundKeys, uint8_t *vector, const uint8_t *in, uint8_t *out,
+                        size_t blocks) {
+    __m128i keys[11];
+    for (size_t round = 0; round <= 10; round++) {
+        keys[round] = _mm_load_si128(reinterpret_cast<const __m128i *>(roundKeys[round]));
+    }
+    __m128i feedback = _mm_loadu_si128(reinterpret_cast<const __m128i *>(vector));
+    for (; blocks > 0; blocks--, in += BLOCK_SIZE, out += BLOCK_SIZE) {
+        feedback = _mm_xor_si128(feedback, keys[0]);
+        for (size_t round = 1; round < 10; round++) {
+            feedback = _mm_aesenc_si128(feedback, keys[round]);
+        }
+        feedback = _mm_aesenclast_si128(feedback, keys[10]);
+        feedback = _mm_xor_si128(feedback, _mm_loadu_si128(reinterpret_cast<const __m128i *>(in)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), feedback);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(vector), feedback);
+}
+
+// 4 路交错，掩盖 AESENC 的延迟
+__attribute__((target("aes,sse2")))
+void decryptBlocksAesni(const RoundKeys &roundKeys, uint8_t *vector, const uint8_t *in, uint8_t *out,
+                        size_t blocks) {
+    __m128i keys[11];
+    for (size_t round = 0; round <= 10; round++) {
+        keys[round] = _mm_load_si128(reinterpret_cast<const __m128i *>(roundKeys[round]));
+    }
+    const auto load = [](const uint8_t *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); };
+    __m128i feedback = load(vector);
+    for (; blocks >= 4; blocks -= 4, in += 4 * BLOCK_SIZE, out += 4 * BLOCK_SIZE) {
+        const __m128i c0 = load(in), c1 = load(in + 16), c2 = load(in + 32), c3 = load(in + 48);
+        __m128i s0 = _mm_xor_si128(feedback, keys[0]);
+        __m128i s1 = _mm_xor_si128(c0, keys[0]);
+        __m128i s2 = _mm_xor_si128(c1, keys[0]);
+        __m128i s3 = _mm_xor_si128(c2, keys[0]);
+        for (size_t round = 1; round < 10; round++) {
+            s0 = _mm_aesenc_si128(s0, keys[round]);
+            s1 = _mm_aesenc_si128(s1, keys[round]);
+            s2 = _mm_aesenc_si128(s2, keys[round]);
+            s3 = _mm_aesenc_si128(s3, keys[round]);
+        }
+        s0 = _mm_aesenclast_si128(s0, keys[10]);
+        s1 = _mm_aesenclast_si128(s1, keys[10]);
+        s2 = _mm_aesenclast_si128(s2, keys[10]);
+        s3 = _mm_aesenclast_si128(s3, keys[10]);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_xor_si128(s0, c0));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 16), _mm_xor_si128(s1, c1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 32), _mm_xor_si128(s2, c2));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 48), _mm_xor_si128(s3, c3));
+        feedback = c3;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(vector), feedback);
+    decryptBlocksSerial<encryptBlockAesni>(roundKeys, vector, in, out, blocks);
+}
+
+const AesCfb128::Implementation AESNI = {encryptBlockAesni, encryptBlocksAesni, decryptBlocksAesni, "aesni"};
+
+#elif defined(__aarch64__)
+
+__attribute__((target("+crypto")))
+void encryptBlockArmv8(const RoundKeys &roundKeys, uint8_t *block) {
+    uint8x16_t state = vld1q_u8(block);
+    for (size_t round = 0; round < 9; round++) {
+        // AESE 先异或轮密钥再做 SubBytes/ShiftRows，AESMC 为 MixColumns
+        state = vaesmcq_u8(vaeseq_u8(state, vld1q_u8(roundKeys[round])));
+    }
+    state = vaeseq_u8(state, vld1q_u8(roundKeys[9]));
+    state = veorq_u8(state, vld1q_u8(roundKeys[10]));
+    vst1q_u8(block, state);
+}
+
+const AesCfb128::Implementation ARMV8 = {
+    encryptBlockArmv8,
+    encryptBlocksSerial<encryptBlockArmv8>,
+    decryptBlocksSerial<encryptBlockArmv8>,
+    "armv8"
+};
+
+#endif
+
+const AesCfb128::Implementation *selectImplementation() {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("aes")) {
+        return &AESNI;
+    }
+#elif defined(__aarch64__)
+    if (getauxval(AT_HWCAP) & HWCAP_AES) {
+        return &ARMV8;
+    }
+#endif
+    return &PORTABLE;
+}
+
+const AesCfb128::Implementation *dispatched() {
+    static const auto selected = selectImplementation();
+    return selected;
+}
+
+} // namespace
+
+AesCfb128::AesCfb128(const void *key, const size_t keyLength, const void *iv, const size_t ivLength)
+    : m_implementation(dispatched()) {
+    uint8_t paddedKey[KEY_SIZE] = {};
+    memcpy(paddedKey, key, std::min(keyLength, KEY_SIZE));
+    expandKey(paddedKey, m_roundKeys);
+    memset(m_vector, 0, BLOCK_SIZE);
+    memcpy(m_vector, iv, std::min(ivLength, BLOCK_SIZE));
+}
+
+AesCfb128::AesCfb128(const uint8_t *roundKeys, const uint8_t *vector, const unsigned number)
+    : m_number(number % BLOCK_SIZE), m_implementation(dispatched()) {
+    memcpy(m_roundKeys, roundKeys, sizeof(m_roundKeys));
+    memcpy(m_vector, vector, BLOCK_SIZE);
+}
+
+const char *AesCfb128::implementation() {
+    return dispatched()->name;
+}
+
+void AesCfb128::usePortable() {
+    m_implementation = &PORTABLE;
+}
+
+void AesCfb128::encrypt(const uint8_t *in, uint8_t *out, const size_t length) {
+    process<true>(in, out, length);
+}
+
+void AesCfb128::decrypt(const uint8_t *in, uint8_t *out, const size_t length) {
+    process<false>(in, out, length);
+}
+
+// 与 AES_cfb128_encrypt 相同：m_number 为当前块内已消耗的字节数，为 0 时先加密反馈向量
+template<bool Encrypt>
+void AesCfb128::process(const uint8_t *in, uint8_t *out, size_t length) {
+    const auto feed = [this](const uint8_t input, uint8_t &output) {
+        const uint8_t result = m_vector[m_number] ^ input;
+        m_vector[m_number] = Encrypt ? result : input;
+        output = result;
+        m_number = (m_number + 1) % BLOCK_SIZE;
+    };
+    while (m_number != 0 && length > 0) {
+        feed(*in++, *out++);
+        length--;
+    }
+    const size_t blocks = length / BLOCK_SIZE;
+    if (blocks > 0) {
+        if (Encrypt) {
+            m_implementation->encryptBlocks(m_roundKeys, m_vector, in, out, blocks);
+        } else {
+            m_implementation->decryptBlocks(m_roundKeys, m_vector, in, out, blocks);
+        }
+        in += blocks * BLOCK_SIZE;
+        out += blocks * BLOCK_SIZE;
+    }
+    length -= blocks * BLOCK_SIZE;
+    if (length > 0) {
+        m_implementation->encryptBlock(m_roundKeys, m_vector);
+        while (length-- > 0) {
+            feed(*in++, *out++);
+        }
+    }
+}
+
+#if defined(MMKV_HW_AES) && defined(__x86_64__)
+// 替换 MMKV AESCrypt 所用的 openssl::AES_set_encrypt_key 与 AES_cfb128_encrypt，链接时先于 libmmkv.a 中的
+// 定义被解析，因此 MMKV 的查表实现不再被链入。两者必须一起替换：AES_KEY 中存放的是本实现按字节顺序的轮密钥。
+// 隐藏可见性，只在 libmmkvc 内部生效；aarch64 上 MMKV 本身已使用 ARMv8 Crypto 指令的汇编实现，不替换。
+// MMKV 修改了这两个声明时，下面的定义会成为重载而不再替换，因此在此检查签名；
+// 是否确实替换由构建后的 cmake/CheckHwAes.cmake 检查
+static_assert(std::is_same_v<decltype(&openssl::AES_set_encrypt_key),
+                             int (*)(const uint8_t *, uint32_t, openssl::AES_KEY *)>,
+              "openssl::AES_set_encrypt_key changed in MMKV, update the MMKV_HW_AES override");
+static_assert(std::is_same_v<decltype(&openssl::AES_cfb128_encrypt),
+                             void (*)(const uint8_t *, uint8_t *, size_t, const openssl::AES_KEY *, uint8_t *, uint32_t *, int)>,
+              "openssl::AES_cfb128_encrypt changed in MMKV, update the MMKV_HW_AES override");
+
+namespace openssl {
+
+__attribute__((visibility("hidden")))
+int AES_set_encrypt_key(const uint8_t *userKey, const uint32_t bits, AES_KEY *key) {
+    if (userKey == nullptr || key == nullptr) {
+        return -1;
+    }
+    // AESCrypt 只使用 AES-128
+    if (bits != AesCfb128::KEY_SIZE * 8) {
+        return -2;
+    }
+    static_assert(sizeof(key->rd_key) >= sizeof(RoundKeys), "AES_KEY cannot hold the round keys");
+    RoundKeys roundKeys;
+    expandKey(userKey, roundKeys);
+    memcpy(key->rd_key, roundKeys, sizeof(roundKeys));
+    key->rounds = 10;
+    return 0;
+}
+
+__attribute__((visibility("hidden")))
+void AES_cfb128_encrypt(const uint8_t *in, uint8_t *out, const size_t length, const AES_KEY *key,
+                        uint8_t ivec[AES_BLOCK_SIZE], uint32_t *num, const int enc) {
+    AesCfb128 cipher(reinterpret_cast<const uint8_t *>(key->rd_key), ivec, *num);
+    if (enc == AES_ENCRYPT) {
+        cipher.encrypt(in, out, length);
+    } else {
+        cipher.decrypt(in, out, length);
+    }
+    memcpy(ivec, cipher.vector(), BLOCK_SIZE);
+    *num = cipher.number();
+}
+
+} // namespace openssl
+#endif
@@ -0,0 +1,48 @@
+#ifndef MMKV_AES_CFB_H
+#define MMKV_AES_CFB_H
+
+#include <cstddef>
+#include <cstdint>
+
+// AES-128 CFB128 加解密，与 MMKV AESCrypt 所用的 OpenSSL AES_cfb128_encrypt 逐字节兼容：
+// 同样维护 16 字节反馈向量与块内偏移，可以跨多次调用流式处理。
+// 运行时按 CPU 选择实现：x86-64 上为 AES-NI，aarch64 上为 ARMv8 Crypto 扩展，否则为查表实现
+class AesCfb128 final {
+public:
+    static constexpr size_t KEY_SIZE = 16;
+    static constexpr size_t BLOCK_SIZE = 16;
+
+    // 与 AESCrypt 一致，key、iv 超过 16 字节时截断，不足时补零
+    AesCfb128(const void *key, size_t keyLength, const void *iv, size_t ivLength);
+
+    // 由已展开的轮密钥（11 × 16 字节，按字节顺序）及上次调用后的 vector、块内偏移继续，
+    // 供替换 MMKV 的 openssl::AES_cfb128_encrypt 使用，状态由调用方保存
+    AesCfb128(const uint8_t *roundKeys, const uint8_t *vector, unsigned number);
+
+    void encrypt(const uint8_t *in, uint8_t *out, size_t length);
+
+    void decrypt(const uint8_t *in, uint8_t *out, size_t length);
+
+    // 当前选用的实现："aesni"、"armv8" 或 "portable"
+    static const char *implementation();
+
+    // 强制使用查表实现，用于基准对比与校验
+    void usePortable();
+
+    const uint8_t *vector() const { return m_vector; }
+
+    unsigned number() const { return m_number; }
+
+    struct Implementation;
+
+private:
+    template<bool Encrypt>
+    void process(const uint8_t *in, uint8_t *out, size_t length);
+
+    alignas(16) uint8_t m_roundKeys[11][BLOCK_SIZE];
+    alignas(16) uint8_t m_vector[BLOCK_SIZE];
+    unsigned m_number = 0;
+    const Implementation *m_implementation;
+};
+
+#endif // MMKV_AES_CFB_H
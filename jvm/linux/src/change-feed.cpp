@@ -0,0 +1,151 @@
+#include "change-feed.h"
+#include "shared-memory.h"
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint32_t CHANGE_FEED_MAGIC = 0x4d4d4b46; // "MMKF"
+constexpr size_t RING_SIZE = 256;
+constexpr size_t KEY_CAPACITY = 116;
+constexpr uint32_t UNKNOWN_KEY = UINT32_MAX;
+
+// 写入中的记录 sequence 为 0，写完后发布为其序号（seqlock）
+struct Entry {
+    std::atomic<uint64_t> sequence;
+    uint32_t keySize;
+    char key[KEY_CAPACITY];
+};
+
+static_assert(sizeof(Entry) == 128, "Entry should fill two cache lines exactly");
+
+long futex(std::atomic<uint32_t> *word, const int op, const uint32_t value, const timespec *timeout) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), op, value, timeout, nullptr, 0);
+}
+
+} // namespace
+
+struct ChangeFeed::State {
+    std::atomic<uint32_t> magic;
+    // 每发布一条记录加一，订阅方在其上 FUTEX_WAIT
+    std::atomic<uint32_t> futexWord;
+    // 正在 FUTEX_WAIT 的线程数，为 0 时发布方省去 FUTEX_WAKE 系统调用
+    std::atomic<uint32_t> waiters;
+    // 最近分配的序号，序号从 1 开始
+    std::atomic<uint64_t> next;
+    Entry entries[RING_SIZE];
+};
+
+ChangeFeed *ChangeFeed::open(const std::string &name) {
+    bool created = false;
+    void *ptr = mapSharedMemory(name, sizeof(State), created);
+    if (ptr == nullptr) {
+        return nullptr;
+    }
+    auto state = static_cast<State *>(ptr);
+    if (created) {
+        // 全零即为初始状态
+        state->magic.store(CHANGE_FEED_MAGIC, std::memory_order_release);
+    } else if (!awaitSharedMemoryReady(state->magic, CHANGE_FEED_MAGIC)) {
+        munmap(state, sizeof(State));
+        return nullptr;
+    }
+    return new ChangeFeed(state);
+}
+
+ChangeFeed::ChangeFeed(State *state) : m_state(state) {}
+
+// 共享内存不 unlink，其他进程可能仍在使用
+ChangeFeed::~ChangeFeed() {
+    munmap(m_state, sizeof(State));
+}
+
+void ChangeFeed::publish(const std::string *key) {
+    const uint64_t sequence = m_state->next.fetch_add(1, std::memory_order_acq_rel) + 1;
+    auto &entry = m_state->entries[sequence % RING_SIZE];
+    entry.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    if (key != nullptr && key->size() <= KEY_CAPACITY) {
+        entry.keySize = static_cast<uint32_t>(key->size());
+        memcpy(entry.key, key->data(), key->size());
+    } else {
+        entry.keySize = UNKNOWN_KEY;
+    }
+    entry.sequence.store(sequence, std::memory_order_release);
+    m_state->futexWord.fetch_add(1, std::memory_order_seq_cst);
+    if (m_state->waiters.load(std::memory_order_seq_cst) > 0) {
+        futex(&m_state->futexWord, FUTEX_WAKE, INT_MAX, nullptr);
+    }
+}
+
+uint64_t ChangeFeed::cursor() const {
+    return m_state->next.load(std::memory_order_acquire);
+}
+
+bool ChangeFeed::collect(uint64_t &cursor, std::vector<std::optional<std::string>> &changes, bool skipStalled) {
+    bool progressed = false;
+    const uint64_t last = m_state->next.load(std::memory_order_acquire);
+    if (last > cursor + RING_SIZE) {
+        // 落后超过一圈，中间的记录已被覆盖
+        changes.emplace_back(std::nullopt);
+        cursor = last - RING_SIZE;
+        progressed = true;
+    }
+    while (cursor < last) {
+        const uint64_t sequence = cursor + 1;
+        const auto &entry = m_state->entries[sequence % RING_SIZE];
+        const auto published = entry.sequence.load(std::memory_order_acquire);
+        if (published == sequence) {
+            const uint32_t size = entry.keySize;
+            std::string key;
+            if (size <= KEY_CAPACITY) {
+                key.assign(entry.key, size);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (size <= KEY_CAPACITY && entry.sequence.load(std::memory_order_relaxed) == sequence) {
+                changes.emplace_back(std::move(key));
+            } else {
+                changes.emplace_back(std::nullopt);
+            }
+        } else if (published > sequence || skipStalled) {
+            // 已被后来的记录覆盖，或写入方在发布前退出
+            changes.emplace_back(std::nullopt);
+            skipStalled = false;
+        } else {
+            // 写入中，发布后会再次唤醒
+            break;
+        }
+        cursor = sequence;
+        progressed = true;
+    }
+    return progressed;
+}
+
+void ChangeFeed::wait(uint64_t &cursor, std::vector<std::optional<std::string>> &changes, const int64_t timeoutMillis) {
+    // 先取 futexWord 再检查记录，之后发布的记录都会使 FUTEX_WAIT 立即返回
+    const auto word = m_state->futexWord.load(std::memory_order_seq_cst);
+    if (collect(cursor, changes, false)) {
+        return;
+    }
+    const timespec timeout{
+        static_cast<time_t>(timeoutMillis / 1000), static_cast<long>(timeoutMillis % 1000) * 1000000L
+    };
+    m_state->waiters.fetch_add(1, std::memory_order_seq_cst);
+    const bool timedOut = futex(&m_state->futexWord, FUTEX_WAIT, word, &timeout) != 0 && errno == ETIMEDOUT;
+    m_state->waiters.fetch_sub(1, std::memory_order_relaxed);
+    // 等满一个周期仍停在同一条记录上时跳过它
+    collect(cursor, changes, timedOut);
+}
+
+void ChangeFeed::wakeAll() {
+    m_state->futexWord.fetch_add(1, std::memory_order_seq_cst);
+    futex(&m_state->futexWord, FUTEX_WAKE, INT_MAX, nullptr);
+}
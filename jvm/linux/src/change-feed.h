@@ -0,0 +1,47 @@
+#ifndef MMKV_CHANGE_FEED_H
+#define MMKV_CHANGE_FEED_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// 跨进程的变更通知，状态位于共享内存中：写入方每次修改在环形日志中追加一条记录（被修改的 key），
+// 递增序号并在其上 FUTEX_WAKE；订阅方在序号上 FUTEX_WAIT，醒来后读取新增的记录，无修改时不占用 CPU。
+// 只记录开启了通知的进程的写入
+class ChangeFeed final {
+public:
+    // 打开或创建 name 对应的共享内存（shm_open 的名字，以 '/' 开头），失败时返回 nullptr
+    static ChangeFeed *open(const std::string &name);
+
+    ~ChangeFeed();
+
+    // 追加一条修改记录，key 为 nullptr 表示无法确定具体 key 的修改（如 clearAll）
+    void publish(const std::string *key);
+
+    // 当前最新的序号，订阅从这里开始
+    uint64_t cursor() const;
+
+    // 等待 cursor 之后的记录，至多等待 timeoutMillis 毫秒，将读到的 key 追加到 changes 并前移 cursor。
+    // std::nullopt 表示未知的修改：key 过长、记录在读取前已被覆盖，或写入方在写记录时退出
+    void wait(uint64_t &cursor, std::vector<std::optional<std::string>> &changes, int64_t timeoutMillis);
+
+    // 唤醒所有正在 wait 的线程，用于取消订阅
+    void wakeAll();
+
+    ChangeFeed(const ChangeFeed &) = delete;
+
+    ChangeFeed &operator=(const ChangeFeed &) = delete;
+
+private:
+    struct State;
+
+    explicit ChangeFeed(State *state);
+
+    // 读取 cursor 之后已发布的记录，返回是否有进展
+    bool collect(uint64_t &cursor, std::vector<std::optional<std::string>> &changes, bool skipStalled);
+
+    State *const m_state;
+};
+
+#endif // MMKV_CHANGE_FEED_H
@@ -0,0 +1,219 @@
+#include "crc32.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_acle.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+namespace {
+
+// 反射多项式 0xedb88320 的 8 张表，table[k][n] 为字节 n 之后再跟 k 个零字节的 CRC
+using SliceTables = std::array<std::array<uint32_t, 256>, 8>;
+
+SliceTables makeSliceTables() {
+    SliceTables tables{};
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t crc = n;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = crc & 1 ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+        }
+        tables[0][n] = crc;
+    }
+    for (uint32_t n = 0; n < 256; n++) {
+        for (size_t k = 1; k < 8; k++) {
+            tables[k][n] = (tables[k - 1][n] >> 8) ^ tables[0][tables[k - 1][n] & 0xff];
+        }
+    }
+    return tables;
+}
+
+const SliceTables &sliceTables() {
+    static const SliceTables tables = makeSliceTables();
+    return tables;
+}
+
+// 以下实现的 state 均为取反后的内部状态，由调用方负责首尾取反
+uint32_t updatePortable(uint32_t state, const uint8_t *buf, size_t len) {
+    const auto &t = sliceTables();
+    while (len >= 8) {
+        uint32_t low, high;
+        memcpy(&low, buf, 4);
+        memcpy(&high, buf + 4, 4);
+        low ^= state;
+        state = t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^ t[5][(low >> 16) & 0xff] ^ t[4][low >> 24] ^
+                t[3][high & 0xff] ^ t[2][(high >> 8) & 0xff] ^ t[1][(high >> 16) & 0xff] ^ t[0][high >> 24];
+        buf += 8;
+        len -= 8;
+    }
+    while (len-- > 0) {
+        state = (state >> 8) ^ t[0][(state ^ *buf++) & 0xff];
+    }
+    return state;
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("pclmul")))
+inline __m128i fold16(const __m128i acc, const __m128i next, const __m128i k) {
+    const __m128i low = _mm_clmulepi64_si128(acc, k, 0x00);
+    const __m128i high = _mm_clmulepi64_si128(acc, k, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(high, next), low);
+}
+
+inline __m128i load128(const uint8_t *p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+
+// 无进位乘法折叠，常数与算法同 Intel 白皮书《Fast CRC Computation for Generic Polynomials Using PCLMULQDQ》
+// 及 Chromium zlib 的 crc32_simd。len 需不小于 64 且为 16 的倍数
+__attribute__((target("pclmul,sse4.1")))
+uint32_t foldPclmul(uint32_t state, const uint8_t *buf, size_t len) {
+    alignas(16) static const uint64_t k1k2[] = {0x0154442bd4, 0x01c6e41596};
+    alignas(16) static const uint64_t k3k4[] = {0x01751997d0, 0x00ccaa009e};
+    alignas(16) static const uint64_t k5k0[] = {0x0163cd6124, 0x0000000000};
+    alignas(16) static const uint64_t poly[] = {0x01db710641, 0x01f7011641};
+
+    __m128i x1 = load128(buf);
+    __m128i x2 = load128(buf + 16);
+    __m128i x3 = load128(buf + 32);
+    __m128i x4 = load128(buf + 48);
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(state)));
+    __m128i x0 = _mm_load_si128(reinterpret_cast<const __m128i *>(k1k2));
+    buf += 64;
+    len -= 64;
+
+    // 每次并行折叠 64 字节
+    while (len >= 64) {
+        const __m128i x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        const __m128i x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        const __m128i x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        const __m128i x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), load128(buf));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), load128(buf + 16));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), load128(buf + 32));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), load128(buf + 48));
+        buf += 64;
+        len -= 64;
+    }
+
+    // 4 路合并为 128 位，再逐 16 字节折叠剩余部分
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i *>(k3k4));
+    x1 = fold16(x1, x2, x0);
+    x1 = fold16(x1, x3, x0);
+    x1 = fold16(x1, x4, x0);
+    while (len >= 16) {
+        x1 = fold16(x1, load128(buf), x0);
+        buf += 16;
+        len -= 16;
+    }
+
+    // 128 位折叠到 64 位
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(k5k0));
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett 约减到 32 位
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i *>(poly));
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+uint32_t updatePclmul(uint32_t state, const uint8_t *buf, size_t len) {
+    if (len >= 64) {
+        const size_t folded = len & ~static_cast<size_t>(15);
+        state = foldPclmul(state, buf, folded);
+        buf += folded;
+        len -= folded;
+    }
+    return updatePortable(state, buf, len);
+}
+
+#elif defined(__aarch64__)
+
+__attribute__((target("+crc")))
+uint32_t updateArmv8(uint32_t state, const uint8_t *buf, size_t len) {
+    while (len >= 8) {
+        uint64_t value;
+        memcpy(&value, buf, 8);
+        state = __crc32d(state, value);
+        buf += 8;
+        len -= 8;
+    }
+    while (len-- > 0) {
+        state = __crc32b(state, *buf++);
+    }
+    return state;
+}
+
+#endif
+
+using UpdateFunction = uint32_t (*)(uint32_t, const uint8_t *, size_t);
+
+struct Implementation {
+    UpdateFunction update;
+    const char *name;
+};
+
+Implementation selectImplementation() {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1")) {
+        return {updatePclmul, "pclmul"};
+    }
+#elif defined(__aarch64__)
+    if (getauxval(AT_HWCAP) & HWCAP_CRC32) {
+        return {updateArmv8, "armv8"};
+    }
+#endif
+    return {updatePortable, "portable"};
+}
+
+const Implementation &implementation() {
+    static const Implementation selected = selectImplementation();
+    return selected;
+}
+
+} // namespace
+
+uint32_t crc32Dispatch(const uint32_t crc, const uint8_t *buf, const size_t len) {
+    return ~implementation().update(~crc, buf, len);
+}
+
+uint32_t crc32Portable(const uint32_t crc, const uint8_t *buf, const size_t len) {
+    return ~updatePortable(~crc, buf, len);
+}
+
+const char *crc32Implementation() {
+    return implementation().name;
+}
+
+#ifdef MMKV_HW_CRC32
+// 替换 MMKV 从系统 zlib 引用的 crc32()。隐藏可见性，只在 libmmkvc 内部生效，不影响进程内其他使用 zlib 的库。
+// MMKV 内嵌 zlib 时引用的是其命名空间内的 crc32，此处不生效；aarch64 上 MMKV 本身已使用 ARMv8 CRC 指令
+extern "C" __attribute__((visibility("hidden")))
+unsigned long crc32(const unsigned long crc, const unsigned char *buf, const unsigned int len) {
+    if (buf == nullptr) {
+        return 0;
+    }
+    return crc32Dispatch(static_cast<uint32_t>(crc), buf, len);
+}
+#endif
@@ -0,0 +1,18 @@
+#ifndef MMKV_CRC32_H
+#define MMKV_CRC32_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 与 zlib crc32() 结果一致的 CRC-32（IEEE 802.3），crc 为上一段的结果，首段传 0
+
+// 运行时按 CPU 选择实现：x86-64 上为 PCLMULQDQ 折叠，aarch64 上为 ARMv8 CRC 指令，否则为 crc32Portable
+uint32_t crc32Dispatch(uint32_t crc, const uint8_t *buf, size_t len);
+
+// 查表（slicing-by-8）实现，所有平台可用
+uint32_t crc32Portable(uint32_t crc, const uint8_t *buf, size_t len);
+
+// 当前 crc32Dispatch 选用的实现："pclmul"、"armv8" 或 "portable"
+const char *crc32Implementation();
+
+#endif // MMKV_CRC32_H
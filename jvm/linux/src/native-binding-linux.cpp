@@ -1,11 +1,758 @@
 #include "MMKV/MMKV.h"
+#include "aes-cfb.h"
+#include "change-feed.h"
+#include "crc32.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <shared_mutex>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace std;
 using namespace mmkv;
 
 typedef void (Logger)(int, const char *, const char *);
 
+// 一条日志，字段仅在回调期间有效；布局需与 Kotlin 侧 NativeLogRecord 保持一致
+struct LogRecord {
+    int32_t level;
+    int32_t line;
+    const char *file;
+    const char *function;
+    const char *message;
+};
+
+// 一次回调投递一批日志
+typedef void (LogBatchHandler)(const LogRecord *, size_t);
+
 static Logger *g_logger = nullptr;
+static LogBatchHandler *g_logBatchHandler = nullptr;
+// 低于该级别的日志在 upcall 之前直接丢弃
+static atomic<int> g_logLevel{MMKVLogInfo};
+// 为 true 时所有日志都由后台线程批量投递，不占用调用方线程
+static bool g_asyncLog = false;
+
+// 持有内部锁期间不能 upcall（回调可能再次访问同一实例而等待这把锁），此时产生的日志先暂存，由后台线程投递
+static thread_local bool t_upcallDeferred = false;
+
+// 可嵌套：写后队列的 drain 会在合并计数的 flush 内再次进入
+class DeferUpcallScope final {
+    const bool m_previous;
+
+public:
+    DeferUpcallScope() : m_previous(t_upcallDeferred) { t_upcallDeferred = true; }
+    ~DeferUpcallScope() { t_upcallDeferred = m_previous; }
+};
+
+struct PendingLog {
+    int level;
+    int line;
+    string file;
+    string function;
+    string message;
+};
+
+static void deliverLogs(const PendingLog *logs, const size_t count) {
+    if (const auto handler = g_logBatchHandler) {
+        vector<LogRecord> records;
+        records.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            const auto &log = logs[i];
+            records.push_back({log.level, log.line, log.file.c_str(), log.function.c_str(), log.message.c_str()});
+        }
+        handler(records.data(), records.size());
+    } else if (const auto logger = g_logger) {
+        for (size_t i = 0; i < count; i++) {
+            logger(logs[i].level, logs[i].file.c_str(), logs[i].message.c_str());
+        }
+    }
+}
+
+// 有界环形缓冲区，写满时丢弃新日志并计数，下一批投递时附带一条说明
+static constexpr size_t LOG_RING_CAPACITY = 1024;
+
+static mutex g_logRingMutex;
+static condition_variable g_logRingCondition;
+static vector<PendingLog> g_logRing;
+static size_t g_logRingHead = 0;
+static size_t g_logRingSize = 0;
+static size_t g_droppedLogs = 0;
+static bool g_logThreadStarted = false;
+
+static void enqueueLog(PendingLog &&log) {
+    lock_guard lock(g_logRingMutex);
+    if (g_logRingSize == LOG_RING_CAPACITY) {
+        g_droppedLogs++;
+        return;
+    }
+    if (g_logRing.empty()) {
+        g_logRing.resize(LOG_RING_CAPACITY);
+    }
+    g_logRing[(g_logRingHead + g_logRingSize) % LOG_RING_CAPACITY] = std::move(log);
+    g_logRingSize++;
+    if (!g_logThreadStarted) {
+        g_logThreadStarted = true;
+        thread([] {
+            vector<PendingLog> batch;
+            unique_lock lock(g_logRingMutex);
+            while (true) {
+                g_logRingCondition.wait(lock, [] { return g_logRingSize > 0; });
+                if (g_droppedLogs > 0) {
+                    batch.push_back({MMKVLogWarning, __LINE__, __FILE__, __func__,
+                                     to_string(g_droppedLogs) + " log records dropped, log buffer is full"});
+                    g_droppedLogs = 0;
+                }
+                for (; g_logRingSize > 0; g_logRingSize--) {
+                    batch.push_back(std::move(g_logRing[g_logRingHead]));
+                    g_logRingHead = (g_logRingHead + 1) % LOG_RING_CAPACITY;
+                }
+                lock.unlock();
+                deliverLogs(batch.data(), batch.size());
+                batch.clear();
+                lock.lock();
+            }
+        }).detach();
+    }
+    g_logRingCondition.notify_one();
+}
+
+// MemoryBudget：登记每个打开的实例及其最近访问时间。设置内存预算后，后台线程定期估算常驻内存，
+// 超出预算时对最久未访问、且已空闲 idleMillis 的实例调用 clearMemoryCache，释放映射与解码后的字典。
+// MMKV 在下次访问时自动重新加载，句柄一直有效。未设置预算时每次访问只多一次原子读
+struct ResidentInstance {
+    explicit ResidentInstance(MMKV *mmkv) : mmkv(mmkv) {}
+
+    MMKV *const mmkv;
+    // steady_clock 毫秒数
+    atomic<int64_t> lastAccess{0};
+    // 被释放后为 false，再次访问时恢复
+    atomic<bool> resident{true};
+    // 最近一次估算的常驻字节数
+    atomic<uint64_t> footprint{0};
+};
+
+// 布局需与 Kotlin 侧 MMKV_MEMORY_BUDGET_STRUCT 保持一致
+struct MMKVMemoryBudgetState {
+    uint64_t budgetBytes;
+    uint64_t residentBytes;
+    uint64_t instances;
+    uint64_t residentInstances;
+    uint64_t evictions;
+};
+
+static shared_mutex g_residentsMutex;
+static unordered_map<const MMKV *, shared_ptr<ResidentInstance>> g_residents;
+static atomic<uint64_t> g_memoryBudget{0};
+static atomic<uint64_t> g_budgetEvictions{0};
+// 串行化预算检查；关闭实例前持有它，保证检查期间登记的实例不会被关闭
+static mutex g_budgetMutex;
+static condition_variable g_budgetCondition;
+static chrono::milliseconds g_budgetIdleTime{0};
+static bool g_budgetThreadStarted = false;
+
+static int64_t steadyMillis() {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void touchInstance(const MMKV *mmkv) {
+    if (g_memoryBudget.load(memory_order_relaxed) == 0) {
+        return;
+    }
+    shared_lock lock(g_residentsMutex);
+    if (const auto it = g_residents.find(mmkv); it != g_residents.end()) {
+        it->second->lastAccess.store(steadyMillis(), memory_order_relaxed);
+        it->second->resident.store(true, memory_order_relaxed);
+    }
+}
+
+static bool isResident(const MMKV *mmkv) {
+    if (g_memoryBudget.load(memory_order_relaxed) == 0) {
+        return true;
+    }
+    shared_lock lock(g_residentsMutex);
+    const auto it = g_residents.find(mmkv);
+    return it == g_residents.end() || it->second->resident.load(memory_order_relaxed);
+}
+
+// 同一个 mmapID 重复打开得到的是同一个实例，只登记一次
+static void trackInstance(MMKV *mmkv) {
+    unique_lock lock(g_residentsMutex);
+    auto &instance = g_residents[mmkv];
+    if (instance == nullptr) {
+        instance = make_shared<ResidentInstance>(mmkv);
+    }
+    instance->lastAccess.store(steadyMillis(), memory_order_relaxed);
+    instance->resident.store(true, memory_order_relaxed);
+}
+
+static void untrackInstance(const MMKV *mmkv) {
+    lock_guard budgetLock(g_budgetMutex);
+    unique_lock lock(g_residentsMutex);
+    g_residents.erase(mmkv);
+}
+
+// 在 g_budgetMutex 内调用，返回本次释放的实例数
+static size_t enforceMemoryBudget() {
+    const auto budget = g_memoryBudget.load(memory_order_relaxed);
+    if (budget == 0) {
+        return 0;
+    }
+    vector<shared_ptr<ResidentInstance>> residents;
+    {
+        shared_lock lock(g_residentsMutex);
+        for (const auto &[_, instance]: g_residents) {
+            if (instance->resident.load(memory_order_relaxed)) {
+                residents.push_back(instance);
+            }
+        }
+    }
+    // 映射的文件加解码后的字典。字典按 actualSize 估计，未加密时值直接引用映射，为上界
+    uint64_t total = 0;
+    for (const auto &instance: residents) {
+        const uint64_t footprint = instance->mmkv->totalSize() + instance->mmkv->actualSize();
+        instance->footprint.store(footprint, memory_order_relaxed);
+        total += footprint;
+    }
+    if (total <= budget) {
+        return 0;
+    }
+    sort(residents.begin(), residents.end(), [](const auto &a, const auto &b) {
+        return a->lastAccess.load(memory_order_relaxed) < b->lastAccess.load(memory_order_relaxed);
+    });
+    const auto idleBefore = steadyMillis() - g_budgetIdleTime.count();
+    size_t evicted = 0;
+    for (const auto &instance: residents) {
+        const auto lastAccess = instance->lastAccess.load(memory_order_relaxed);
+        if (total <= budget || lastAccess > idleBefore) {
+            break;
+        }
+        instance->mmkv->clearMemoryCache();
+        // 释放期间被访问过的实例已重新加载，仍视为常驻
+        if (instance->lastAccess.load(memory_order_relaxed) == lastAccess) {
+            instance->resident.store(false, memory_order_relaxed);
+        }
+        total -= instance->footprint.load(memory_order_relaxed);
+        evicted++;
+    }
+    g_budgetEvictions.fetch_add(evicted, memory_order_relaxed);
+    return evicted;
+}
+
+// 空闲时间的一半作为检查间隔，限制在 [10ms, 1s]
+static chrono::milliseconds budgetCheckInterval() {
+    return min(chrono::milliseconds(1000), max(g_budgetIdleTime / 2, chrono::milliseconds(10)));
+}
+
+static void runMemoryBudget() {
+    unique_lock lock(g_budgetMutex);
+    while (true) {
+        if (g_memoryBudget.load(memory_order_relaxed) == 0) {
+            g_budgetCondition.wait(lock);
+            continue;
+        }
+        g_budgetCondition.wait_for(lock, budgetCheckInterval());
+        enforceMemoryBudget();
+    }
+}
+
+// 设置所有实例合计的内存预算，budgetBytes 为 0 时关闭。只释放 idleMillis 毫秒内未被访问的实例
+extern "C" void mmkv_setMemoryBudget(const uint64_t budgetBytes, const int64_t idleMillis) {
+    lock_guard lock(g_budgetMutex);
+    g_budgetIdleTime = chrono::milliseconds(max<int64_t>(idleMillis, 0));
+    g_memoryBudget.store(budgetBytes, memory_order_relaxed);
+    if (budgetBytes > 0 && !g_budgetThreadStarted) {
+        g_budgetThreadStarted = true;
+        thread(runMemoryBudget).detach();
+    }
+    g_budgetCondition.notify_all();
+}
+
+// 立即按预算检查一次，返回释放的实例数
+extern "C" size_t mmkv_enforceMemoryBudget() {
+    lock_guard lock(g_budgetMutex);
+    return enforceMemoryBudget();
+}
+
+// residentBytes 为最近一次检查时的估算值
+extern "C" void mmkv_memoryBudgetState(MMKVMemoryBudgetState *out) {
+    out->budgetBytes = g_memoryBudget.load(memory_order_relaxed);
+    out->residentBytes = 0;
+    out->residentInstances = 0;
+    out->evictions = g_budgetEvictions.load(memory_order_relaxed);
+    shared_lock lock(g_residentsMutex);
+    out->instances = g_residents.size();
+    for (const auto &[_, instance]: g_residents) {
+        if (instance->resident.load(memory_order_relaxed)) {
+            out->residentBytes += instance->footprint.load(memory_order_relaxed);
+            out->residentInstances++;
+        }
+    }
+}
+
+// Stats：按实例开启的计数器与耗时直方图，未开启任何实例时每次调用只有一次原子读。
+// 追加字节数、全量回写与文件扩容由写入前后的 actualSize/totalSize 推断，多线程并发写入时为近似值
+static constexpr size_t LATENCY_BUCKETS = 32;
+
+// 布局需与 Kotlin 侧 MMKV_STATS_STRUCT 保持一致；直方图第 i 项为耗时在 [2^i, 2^(i+1)) 纳秒内的次数
+struct MMKVStats {
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t bytesAppended;
+    uint64_t fullWritebacks;
+    uint64_t fileExpansions;
+    uint64_t trims;
+    uint64_t reloads;
+    uint64_t crcFailures;
+    uint64_t lockWaitNanos;
+    uint64_t getLatency[LATENCY_BUCKETS];
+    uint64_t setLatency[LATENCY_BUCKETS];
+};
+
+struct InstanceStats {
+    explicit InstanceStats(string mmapID) : mmapID(std::move(mmapID)) {}
+
+    const string mmapID;
+    atomic<uint64_t> reads{0};
+    atomic<uint64_t> writes{0};
+    atomic<uint64_t> bytesAppended{0};
+    atomic<uint64_t> fullWritebacks{0};
+    atomic<uint64_t> fileExpansions{0};
+    atomic<uint64_t> trims{0};
+    atomic<uint64_t> reloads{0};
+    atomic<uint64_t> crcFailures{0};
+    atomic<uint64_t> lockWaitNanos{0};
+    atomic<uint64_t> getLatency[LATENCY_BUCKETS]{};
+    atomic<uint64_t> setLatency[LATENCY_BUCKETS]{};
+};
+
+static shared_mutex g_statsMutex;
+static unordered_map<const MMKV *, shared_ptr<InstanceStats>> g_stats;
+static atomic<size_t> g_statsCount{0};
+
+static shared_ptr<InstanceStats> instanceStats(const MMKV *mmkv) {
+    if (g_statsCount.load(memory_order_acquire) == 0) {
+        return nullptr;
+    }
+    shared_lock lock(g_statsMutex);
+    const auto it = g_stats.find(mmkv);
+    return it != g_stats.end() ? it->second : nullptr;
+}
+
+// MMKVHandler 的回调只带 mmapID
+template<typename F>
+static void forEachStatsOf(const string &mmapID, F &&action) {
+    if (g_statsCount.load(memory_order_acquire) == 0) {
+        return;
+    }
+    shared_lock lock(g_statsMutex);
+    for (const auto &[_, stats]: g_stats) {
+        if (stats->mmapID == mmapID) {
+            action(*stats);
+        }
+    }
+}
+
+static uint64_t nanosSince(const chrono::steady_clock::time_point start) {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+}
+
+static size_t latencyBucket(const uint64_t nanos) {
+    size_t bucket = 0;
+    for (auto value = nanos; value > 1 && bucket < LATENCY_BUCKETS - 1; value >>= 1) {
+        bucket++;
+    }
+    return bucket;
+}
+
+// 记录一次读、写或整理操作
+class StatsScope final {
+public:
+    enum Kind { Read, Write, Maintenance };
+
+    StatsScope(MMKV *mmkv, const Kind kind) : m_stats(instanceStats(mmkv)), m_mmkv(mmkv), m_kind(kind) {
+        if (m_stats == nullptr) {
+            return;
+        }
+        if (m_kind != Read) {
+            m_actualSize = m_mmkv->actualSize();
+            m_totalSize = m_mmkv->totalSize();
+        }
+        m_start = chrono::steady_clock::now();
+    }
+
+    ~StatsScope() {
+        if (m_stats == nullptr) {
+            return;
+        }
+        const auto bucket = latencyBucket(nanosSince(m_start));
+        if (m_kind == Read) {
+            m_stats->reads.fetch_add(1, memory_order_relaxed);
+            m_stats->getLatency[bucket].fetch_add(1, memory_order_relaxed);
+            return;
+        }
+        if (m_kind == Write) {
+            m_stats->writes.fetch_add(1, memory_order_relaxed);
+            m_stats->setLatency[bucket].fetch_add(1, memory_order_relaxed);
+        }
+        if (const auto actualSize = m_mmkv->actualSize(); actualSize > m_actualSize) {
+            m_stats->bytesAppended.fetch_add(actualSize - m_actualSize, memory_order_relaxed);
+        } else if (actualSize < m_actualSize) {
+            m_stats->fullWritebacks.fetch_add(1, memory_order_relaxed);
+        }
+        if (m_mmkv->totalSize() > m_totalSize) {
+            m_stats->fileExpansions.fetch_add(1, memory_order_relaxed);
+        }
+    }
+
+    StatsScope(const StatsScope &) = delete;
+    StatsScope &operator=(const StatsScope &) = delete;
+
+private:
+    const shared_ptr<InstanceStats> m_stats;
+    MMKV *const m_mmkv;
+    const Kind m_kind;
+    size_t m_actualSize = 0;
+    size_t m_totalSize = 0;
+    chrono::steady_clock::time_point m_start;
+};
+
+// 开启时从零开始计数，关闭时丢弃已有的计数
+extern "C" void mmkv_enableStats(MMKV *mmkv, const bool enable) {
+    unique_lock lock(g_statsMutex);
+    if (const auto it = g_stats.find(mmkv); it != g_stats.end()) {
+        if (!enable) {
+            g_stats.erase(it);
+            g_statsCount.fetch_sub(1, memory_order_release);
+        }
+    } else if (enable) {
+        g_stats.emplace(mmkv, make_shared<InstanceStats>(mmkv->mmapID()));
+        g_statsCount.fetch_add(1, memory_order_release);
+    }
+}
+
+// 未开启 Stats 时返回 false
+extern "C" bool mmkv_stats(MMKV *mmkv, MMKVStats *out) {
+    const auto stats = instanceStats(mmkv);
+    if (stats == nullptr) {
+        return false;
+    }
+    out->reads = stats->reads.load(memory_order_relaxed);
+    out->writes = stats->writes.load(memory_order_relaxed);
+    out->bytesAppended = stats->bytesAppended.load(memory_order_relaxed);
+    out->fullWritebacks = stats->fullWritebacks.load(memory_order_relaxed);
+    out->fileExpansions = stats->fileExpansions.load(memory_order_relaxed);
+    out->trims = stats->trims.load(memory_order_relaxed);
+    out->reloads = stats->reloads.load(memory_order_relaxed);
+    out->crcFailures = stats->crcFailures.load(memory_order_relaxed);
+    out->lockWaitNanos = stats->lockWaitNanos.load(memory_order_relaxed);
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        out->getLatency[i] = stats->getLatency[i].load(memory_order_relaxed);
+        out->setLatency[i] = stats->setLatency[i].load(memory_order_relaxed);
+    }
+    return true;
+}
+
+// 由 mmapID 等任意字符串派生稳定的文件名：FNV-1a 哈希的 16 位十六进制表示
+static string hashName(const string &value) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const auto c: value) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ULL;
+    }
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+    return name;
+}
+
+// ChangeFeed：开启后本进程对该实例的修改记入共享内存中的变更日志，任意进程可订阅，订阅方在 futex 上等待，
+// 不再需要轮询。订阅时自动开启；写入方进程需各自开启，未开启的进程的写入不会被通知
+static shared_mutex g_changeFeedsMutex;
+static unordered_map<const MMKV *, shared_ptr<ChangeFeed>> g_changeFeeds;
+static atomic<size_t> g_changeFeedCount{0};
+
+static shared_ptr<ChangeFeed> instanceChangeFeed(const MMKV *mmkv) {
+    if (g_changeFeedCount.load(memory_order_acquire) == 0) {
+        return nullptr;
+    }
+    shared_lock lock(g_changeFeedsMutex);
+    const auto it = g_changeFeeds.find(mmkv);
+    return it != g_changeFeeds.end() ? it->second : nullptr;
+}
+
+// 修改成功后调用，key 为 nullptr 表示无法确定具体 key 的修改
+static void notifyChange(const MMKV *mmkv, const string *key) {
+    if (const auto feed = instanceChangeFeed(mmkv)) {
+        feed->publish(key);
+    }
+}
+
+static bool notifyIf(const bool changed, const MMKV *mmkv, const string &key) {
+    if (changed) {
+        notifyChange(mmkv, &key);
+    }
+    return changed;
+}
+
+static void notifyChanges(const MMKV *mmkv, const vector<string> &keys) {
+    if (const auto feed = instanceChangeFeed(mmkv)) {
+        for (const auto &key: keys) {
+            feed->publish(&key);
+        }
+    }
+}
+
+static string changeFeedName(const MMKV *mmkv) {
+    return "/mmkv-feed-" + hashName(MMKV::getRootDir() + "/" + mmkv->mmapID());
+}
+
+// 共享内存不可用时返回 false
+extern "C" bool mmkv_enableChangeNotify(MMKV *mmkv, const bool enable) {
+    unique_lock lock(g_changeFeedsMutex);
+    if (const auto it = g_changeFeeds.find(mmkv); it != g_changeFeeds.end()) {
+        if (!enable) {
+            g_changeFeeds.erase(it);
+            g_changeFeedCount.fetch_sub(1, memory_order_release);
+        }
+        return enable;
+    }
+    if (!enable) {
+        return false;
+    }
+    const shared_ptr<ChangeFeed> feed(ChangeFeed::open(changeFeedName(mmkv)));
+    if (feed == nullptr) {
+        return false;
+    }
+    g_changeFeeds.emplace(mmkv, feed);
+    g_changeFeedCount.fetch_add(1, memory_order_release);
+    return true;
+}
+
+// 订阅回调，参数依次为订阅时传入的 context、key 及其长度；key 为 nullptr 表示未知的修改，订阅方应当重新读取关心的所有 key
+typedef void (ChangeCallback)(void *, const char *, size_t);
+
+struct ChangeWatch {
+    const MMKV *mmkv;
+    shared_ptr<ChangeFeed> feed;
+    string prefix;
+    ChangeCallback *callback;
+    void *context;
+    atomic<bool> stopped{false};
+    thread worker;
+};
+
+// 等待的时间上限，到期后跳过写入方未写完的记录
+static constexpr int64_t WATCH_WAIT_MILLIS = 1000;
+
+static mutex g_watchesMutex;
+static unordered_map<int64_t, shared_ptr<ChangeWatch>> g_watches;
+static int64_t g_nextWatchId = 1;
+
+static void runWatch(const shared_ptr<ChangeWatch> &watch, uint64_t cursor) {
+    vector<optional<string>> changes;
+    unordered_set<string> delivered;
+    while (!watch->stopped.load(memory_order_acquire)) {
+        changes.clear();
+        watch->feed->wait(cursor, changes, WATCH_WAIT_MILLIS);
+        // 同一批中重复的 key 只回调一次
+        delivered.clear();
+        bool unknownDelivered = false;
+        for (const auto &key: changes) {
+            if (watch->stopped.load(memory_order_acquire)) {
+                return;
+            }
+            if (!key.has_value()) {
+                if (!unknownDelivered) {
+                    unknownDelivered = true;
+                    watch->callback(watch->context, nullptr, 0);
+                }
+            } else if (key->compare(0, watch->prefix.size(), watch->prefix) == 0 && delivered.insert(*key).second) {
+                watch->callback(watch->context, key->data(), key->size());
+            }
+        }
+    }
+}
+
+// 订阅 key 以 prefix 开头的修改（prefixSize 为 0 时订阅所有修改），在后台线程上回调 callback，
+// 返回订阅 id，共享内存不可用时返回 0。只通知订阅之后发生的修改
+extern "C" int64_t mmkv_watch(MMKV *mmkv, const char *prefix, const size_t prefixSize, ChangeCallback *callback,
+                              void *context) {
+    if (!mmkv_enableChangeNotify(mmkv, true)) {
+        return 0;
+    }
+    const auto feed = instanceChangeFeed(mmkv);
+    if (feed == nullptr) {
+        return 0;
+    }
+    auto watch = make_shared<ChangeWatch>();
+    watch->mmkv = mmkv;
+    watch->feed = feed;
+    watch->prefix.assign(prefix != nullptr ? prefix : "", prefix != nullptr ? prefixSize : 0);
+    watch->callback = callback;
+    watch->context = context;
+    lock_guard lock(g_watchesMutex);
+    const auto id = g_nextWatchId++;
+    watch->worker = thread(runWatch, watch, feed->cursor());
+    g_watches.emplace(id, std::move(watch));
+    return id;
+}
+
+// 取消订阅，返回后不再回调；可在回调中调用
+extern "C" void mmkv_unwatch(const int64_t id) {
+    shared_ptr<ChangeWatch> watch;
+    {
+        lock_guard lock(g_watchesMutex);
+        const auto it = g_watches.find(id);
+        if (it == g_watches.end()) {
+            return;
+        }
+        watch = std::move(it->second);
+        g_watches.erase(it);
+    }
+    watch->stopped.store(true, memory_order_release);
+    watch->feed->wakeAll();
+    if (watch->worker.get_id() == this_thread::get_id()) {
+        watch->worker.detach();
+    } else {
+        watch->worker.join();
+    }
+}
+
+static void unwatchAll(const MMKV *mmkv) {
+    vector<int64_t> ids;
+    {
+        lock_guard lock(g_watchesMutex);
+        for (const auto &[id, watch]: g_watches) {
+            if (watch->mmkv == mmkv) {
+                ids.push_back(id);
+            }
+        }
+    }
+    for (const auto id: ids) {
+        mmkv_unwatch(id);
+    }
+}
+
+// ReKeyGate：换密钥时从备份开始到 REWRITTEN 标记落盘，runReKey 独占持有实例的闸门，
+// 其他线程经 InstanceLock 的修改在闸门上等待，不会写进随后可能被恢复掉的旧文件。
+// 未在换密钥时，每个 InstanceLock 只多两次原子操作
+static shared_mutex g_reKeyGatesMutex;
+static unordered_map<const MMKV *, shared_ptr<shared_mutex>> g_reKeyGates;
+static atomic<size_t> g_reKeyGateCount{0};
+// 查询闸门时未见到任何闸门、因而不经闸门执行的修改数，闸门建立后需等它们结束
+static atomic<size_t> g_ungatedWrites{0};
+// 持有闸门的线程，其自身的 InstanceLock 不再经过闸门
+static thread_local const MMKV *t_reKeyGateOwner = nullptr;
+
+// 返回 nullptr 时调用方仍计在 g_ungatedWrites 中；与 closeReKeyGate 按 Dekker 方式配对，两者都用 seq_cst。
+// 查找期间一直计数，闸门在查找之后才登记时，closeReKeyGate 会等本次修改结束
+static shared_ptr<shared_mutex> enterReKeyGate(const MMKV *mmkv) {
+    if (t_reKeyGateOwner == mmkv) {
+        return nullptr;
+    }
+    g_ungatedWrites.fetch_add(1);
+    if (g_reKeyGateCount.load() == 0) {
+        return nullptr;
+    }
+    shared_ptr<shared_mutex> gate;
+    {
+        shared_lock lock(g_reKeyGatesMutex);
+        if (const auto it = g_reKeyGates.find(mmkv); it != g_reKeyGates.end()) {
+            gate = it->second;
+        }
+    }
+    if (gate != nullptr) {
+        // 闸门登记前已被独占，先撤销计数，否则 closeReKeyGate 与这里互相等待
+        g_ungatedWrites.fetch_sub(1);
+        gate->lock_shared();
+    }
+    return gate;
+}
+
+static void leaveReKeyGate(const MMKV *mmkv, const shared_ptr<shared_mutex> &gate) {
+    if (gate != nullptr) {
+        gate->unlock_shared();
+    } else if (t_reKeyGateOwner != mmkv) {
+        g_ungatedWrites.fetch_sub(1);
+    }
+}
+
+// 建立并独占 mmkv 的闸门，返回时所有进行中的修改都已结束
+static shared_ptr<shared_mutex> closeReKeyGate(const MMKV *mmkv) {
+    const auto gate = make_shared<shared_mutex>();
+    gate->lock();
+    {
+        unique_lock lock(g_reKeyGatesMutex);
+        g_reKeyGates.emplace(mmkv, gate);
+    }
+    g_reKeyGateCount.fetch_add(1);
+    // 建立闸门之前开始的修改很短，让出 CPU 等待即可
+    while (g_ungatedWrites.load() != 0) {
+        this_thread::yield();
+    }
+    t_reKeyGateOwner = mmkv;
+    return gate;
+}
+
+static void openReKeyGate(const MMKV *mmkv, const shared_ptr<shared_mutex> &gate) {
+    t_reKeyGateOwner = nullptr;
+    {
+        unique_lock lock(g_reKeyGatesMutex);
+        g_reKeyGates.erase(mmkv);
+    }
+    g_reKeyGateCount.fetch_sub(1);
+    gate->unlock();
+}
+
+// 绑定层的实例锁，开启 Stats 时累计等待时间
+class InstanceLock final {
+public:
+    enum Mode {
+        Exclusive, // MMKV 文件锁，用于批量写入
+        Shared,    // 同为 MMKV 文件锁（MMKV 不提供读锁），用于批量读取
+        Write,     // 不加文件锁，MMKV 写入时自行加锁；只在换密钥期间等待
+    };
+
+    InstanceLock(MMKV *mmkv, const Mode mode) : m_mmkv(mmkv), m_mode(mode), m_reKeyGate(enterReKeyGate(mmkv)) {
+        if (m_mode == Write) {
+            return;
+        }
+        const auto stats = instanceStats(m_mmkv);
+        const auto start = stats != nullptr ? chrono::steady_clock::now() : chrono::steady_clock::time_point();
+        m_mmkv->lock();
+        if (stats != nullptr) {
+            stats->lockWaitNanos.fetch_add(nanosSince(start), memory_order_relaxed);
+        }
+    }
+
+    ~InstanceLock() {
+        if (m_mode != Write) {
+            m_mmkv->unlock();
+        }
+        leaveReKeyGate(m_mmkv, m_reKeyGate);
+    }
+
+    InstanceLock(const InstanceLock &) = delete;
+    InstanceLock &operator=(const InstanceLock &) = delete;
+
+private:
+    MMKV *const m_mmkv;
+    const Mode m_mode;
+    const shared_ptr<shared_mutex> m_reKeyGate;
+};
 
 class KotlinMMKVHandler final : public MMKVHandler {
 public:
@@ -14,10 +761,26 @@ public:
                  int line,
                  const char *function,
                  MMKVLog_t message) override {
-        if (g_logger) {
-            g_logger(level, file, message.c_str());
+        if (level < g_logLevel.load(memory_order_relaxed) || (g_logBatchHandler == nullptr && g_logger == nullptr)) {
+            return;
+        }
+        PendingLog log{level, line, file != nullptr ? file : "", function != nullptr ? function : "", message};
+        if (t_upcallDeferred || g_asyncLog) {
+            enqueueLog(std::move(log));
+        } else {
+            deliverLogs(&log, 1);
         }
     }
+
+    MMKVRecoverStrategic onMMKVCRCCheckFail(const string &mmapID) override {
+        forEachStatsOf(mmapID, [](InstanceStats &stats) { stats.crcFailures.fetch_add(1, memory_order_relaxed); });
+        return OnErrorDiscard;
+    }
+
+    // 多进程模式下检测到其他进程修改后重新加载
+    void onContentChangedByOuterProcess(const string &mmapID) override {
+        forEachStatsOf(mmapID, [](InstanceStats &stats) { stats.reloads.fetch_add(1, memory_order_relaxed); });
+    }
 };
 
 static KotlinMMKVHandler g_handler;
@@ -37,11 +800,131 @@ static char *stringToChar(const string &src) {
 
 extern "C" void mmkv_initialize(const char *path, int level, Logger *logger) {
     g_logger = logger;
+    g_logLevel.store(level, memory_order_relaxed);
     MMKV::initializeMMKV(path, static_cast<MMKVLogLevel>(level), logger != nullptr ? &g_handler : nullptr);
 }
 
 
+// 与 mmkv_initialize 相同，日志带上 file/line/function 并按批投递；async 为 true 时日志全部由后台线程投递
+extern "C" void mmkv_initializeWithLogHandler(const char *path, int level, LogBatchHandler *handler, bool async) {
+    g_logBatchHandler = handler;
+    g_asyncLog = async;
+    g_logLevel.store(level, memory_order_relaxed);
+    MMKV::initializeMMKV(path, static_cast<MMKVLogLevel>(level), handler != nullptr ? &g_handler : nullptr);
+}
+
+// ReKey：在后台线程上换密钥，开始前把实例备份到 <root>/.rekey/<hash>，完成后删除。
+// 进程在换密钥中途退出时，下次打开前从备份恢复，实例仍为旧密钥下的完整数据
+enum ReKeyStage : int32_t {
+    ReKeyBackedUp = 0,
+    ReKeyRewritten = 1,
+    ReKeyFinished = 2,
+    ReKeyFailed = 3,
+};
+
+typedef void (ReKeyCallback)(MMKV *, int32_t);
+
+// 与 MMKV 内部默认实例的 mmapID 一致
+static constexpr const char *DEFAULT_INSTANCE_ID = "mmkv.default";
+
+static mutex g_reKeyMutex;
+static condition_variable g_reKeyFinished;
+// 正在换密钥的实例及其 mmapID，打开时据此跳过恢复
+static unordered_map<const MMKV *, string> g_reKeyJobs;
+
+static MMKVPath_t reKeyBackupDir(const MMKVPath_t &rootDir, const string &mmapID) {
+    return rootDir + "/.rekey/" + hashName(mmapID);
+}
+
+// 备份目录旁的标记文件，放在目录外以免与 mmapID 同名的备份文件冲突：
+// BACKED_UP 表示备份已完整落盘，REWRITTEN 表示新密钥已写完并落盘
+static constexpr const char *REKEY_BACKED_UP = ".backed-up";
+static constexpr const char *REKEY_REWRITTEN = ".rewritten";
+
+// fsync 目录本身，使其中文件的创建、删除与 rename 持久化
+static bool syncDirectory(const MMKVPath_t &dir) {
+    const int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    const bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+}
+
+static bool syncFile(const MMKVPath_t &path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    const bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+}
+
+// 标记之前先 fsync 备份目录中的文件，标记出现时它所代表的状态一定已经落盘
+static bool markReKey(const MMKVPath_t &backupDir, const char *marker) {
+    error_code ec;
+    for (const auto &entry: filesystem::directory_iterator(backupDir, ec)) {
+        if (entry.is_regular_file(ec) && !syncFile(entry.path())) {
+            return false;
+        }
+    }
+    const auto path = backupDir + marker;
+    const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    const bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced && syncDirectory(filesystem::path(backupDir).parent_path());
+}
+
+// 先删 BACKED_UP 再删 REWRITTEN，中途退出时不会只剩下 BACKED_UP 而把已换密钥的数据回滚
+static void removeReKeyBackup(const MMKVPath_t &backupDir) {
+    const auto parent = filesystem::path(backupDir).parent_path();
+    error_code ec;
+    filesystem::remove(backupDir + REKEY_BACKED_UP, ec);
+    syncDirectory(parent);
+    filesystem::remove(backupDir + REKEY_REWRITTEN, ec);
+    filesystem::remove_all(backupDir, ec);
+    syncDirectory(parent);
+}
+
+static void recoverInterruptedReKey(const string &mmapID, const char *rootPath) {
+    const MMKVPath_t root = rootPath != nullptr ? MMKVPath_t(rootPath) : MMKV::getRootDir();
+    const auto backupDir = reKeyBackupDir(root, mmapID);
+    error_code ec;
+    if (!filesystem::exists(backupDir, ec) && !filesystem::exists(backupDir + REKEY_REWRITTEN, ec)) {
+        return;
+    }
+    {
+        lock_guard lock(g_reKeyMutex);
+        for (const auto &[_, id]: g_reKeyJobs) {
+            if (id == mmapID) {
+                return;
+            }
+        }
+    }
+    // 只有备份完整且改写确定未完成时才恢复；已改写完成时备份作废，备份不完整时原文件尚未改动
+    if (!filesystem::exists(backupDir + REKEY_REWRITTEN, ec) && filesystem::exists(backupDir + REKEY_BACKED_UP, ec) &&
+        !MMKV::restoreOneFromDirectory(mmapID, backupDir, rootPath != nullptr ? &root : nullptr)) {
+        // 恢复失败时保留备份，下次打开再试
+        return;
+    }
+    removeReKeyBackup(backupDir);
+}
+
+// 等待进行中的换密钥结束，关闭实例前调用
+static void awaitReKey(const MMKV *mmkv) {
+    unique_lock lock(g_reKeyMutex);
+    g_reKeyFinished.wait(lock, [mmkv] { return g_reKeyJobs.find(mmkv) == g_reKeyJobs.end(); });
+}
+
+static void recoverTransaction(MMKV *mmkv, const char *rootPath);
+
 extern "C" MMKV *mmkv_defaultMMKV(int mode, const char *cryptKey) {
+    recoverInterruptedReKey(DEFAULT_INSTANCE_ID, nullptr);
     MMKV *mmkv = nullptr;
     if (isNotNullOrEmpty(cryptKey)) {
         const string crypt(cryptKey);
@@ -50,101 +933,989 @@ extern "C" MMKV *mmkv_defaultMMKV(int mode, const char *cryptKey) {
         mmkv = MMKV::defaultMMKV(static_cast<MMKVMode>(mode));
     }
     mmkv->enableAutoKeyExpire(MMKV::ExpireNever);
+    recoverTransaction(mmkv, nullptr);
+    trackInstance(mmkv);
+    return mmkv;
+}
+
+extern "C" MMKV *mmkv_mmkvWithID(const char *id, int mode, const char *cryptKey, const char *path) {
+    recoverInterruptedReKey(id, isNotNullOrEmpty(path) ? path : nullptr);
+    MMKV *mmkv = nullptr;
+    if (isNotNullOrEmpty(cryptKey) && isNotNullOrEmpty(path)) {
+        const string crypt(cryptKey);
+        const string rootPath(path);
+        mmkv = MMKV::mmkvWithID(id, static_cast<MMKVMode>(mode), &crypt, &rootPath);
+    } else if (isNotNullOrEmpty(cryptKey) && path == nullptr) {
+        const string crypt(cryptKey);
+        mmkv = MMKV::mmkvWithID(id, static_cast<MMKVMode>(mode), &crypt);
+    } else if (isNotNullOrEmpty(path) && cryptKey == nullptr) {
+        const MMKVPath_t rootPath(path);
+        mmkv = MMKV::mmkvWithID(id, static_cast<MMKVMode>(mode), nullptr, &rootPath);
+    } else {
+        mmkv = MMKV::mmkvWithID(id, static_cast<MMKVMode>(mode));
+    }
+    mmkv->enableAutoKeyExpire(MMKV::ExpireNever);
+    recoverTransaction(mmkv, isNotNullOrEmpty(path) ? path : nullptr);
+    trackInstance(mmkv);
     return mmkv;
 }
 
-extern "C" MMKV *mmkv_mmkvWithID(const char *id, int mode, const char *cryptKey, const char *path) {
-    MMKV *mmkv = nullptr;
-    if (isNotNullOrEmpty(cryptKey) && isNotNullOrEmpty(path)) {
-        const string crypt(cryptKey);
-        const string rootPath(path);
-        mmkv = MMKV::mmkvWithID(id, static_cast<MMKVMode>(mode), &crypt, &rootPath);
-    } else if (isNotNullOrEmpty(cryptKey) && path == nullptr) {
-        const string crypt(cryptKey);
-        mmkv = MMKV::mmkvWithID(id, static_cast<MMKVMode>(mode), &crypt);
-    } else if (isNotNullOrEmpty(path) && cryptKey == nullptr) {
-        const MMKVPath_t rootPath(path);
-        mmkv = MMKV::mmkvWithID(id, static_cast<MMKVMode>(mode), nullptr, &rootPath);
-    } else {
-        mmkv = MMKV::mmkvWithID(id, static_cast<MMKVMode>(mode));
-    }
-    mmkv->enableAutoKeyExpire(MMKV::ExpireNever);
-    return mmkv;
+// Preload
+typedef void (PreloadCallback)(size_t, MMKV *);
+
+// 把数据文件与 .crc 预读进 page cache。mmapID 含特殊字符时 MMKV 以 md5 命名文件，此时跳过
+static void prefetchInstanceFiles(const string &mmapID) {
+    if (mmapID.find_first_of("\\/:*?\"<>|") != string::npos) {
+        return;
+    }
+    const auto path = MMKV::getRootDir() + "/" + mmapID;
+    for (const auto &file: {path, path + ".crc"}) {
+        const int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        if (struct stat st{}; fstat(fd, &st) == 0 && st.st_size > 0) {
+            readahead(fd, 0, static_cast<size_t>(st.st_size));
+        }
+        close(fd);
+    }
+}
+
+// 在 threads 个工作线程上打开 n 个实例（threads 为 0 时取 CPU 核数），句柄按下标写入 out，打开失败的为 nullptr；
+// callback 不为 nullptr 时每打开一个即在工作线程上回调一次。返回成功打开的个数。
+// 文件读取在各线程并行进行，MMKV 构造实例时持有全局锁，解析与校验仍是串行的
+extern "C" size_t mmkv_preload(const char **ids, const int *modes, const size_t n, size_t threads,
+                               MMKV **out, PreloadCallback *callback) {
+    if (threads == 0) {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    threads = min(threads, n);
+    atomic<size_t> next{0};
+    atomic<size_t> opened{0};
+    auto worker = [&] {
+        for (auto i = next.fetch_add(1); i < n; i = next.fetch_add(1)) {
+            const string id(ids[i]);
+            recoverInterruptedReKey(id, nullptr);
+            prefetchInstanceFiles(id);
+            const auto mmkv = MMKV::mmkvWithID(id, static_cast<MMKVMode>(modes[i]));
+            if (mmkv != nullptr) {
+                mmkv->enableAutoKeyExpire(MMKV::ExpireNever);
+                recoverTransaction(mmkv, nullptr);
+                trackInstance(mmkv);
+                opened.fetch_add(1, memory_order_relaxed);
+            }
+            out[i] = mmkv;
+            if (callback != nullptr) {
+                callback(i, mmkv);
+            }
+        }
+    };
+    vector<thread> pool;
+    pool.reserve(threads > 0 ? threads - 1 : 0);
+    for (size_t i = 1; i < threads; i++) {
+        pool.emplace_back(worker);
+    }
+    // 调用线程也参与打开
+    worker();
+    for (auto &t: pool) {
+        t.join();
+    }
+    return opened.load(memory_order_relaxed);
+}
+
+// 批量记录的值类型，需与 Kotlin 侧 NativeValueType 保持一致
+enum NativeValueType : uint32_t {
+    TypeBoolean = 0,
+    TypeInt = 1,
+    TypeUInt = 2,
+    TypeLong = 3,
+    TypeULong = 4,
+    TypeFloat = 5,
+    TypeDouble = 6,
+    TypeString = 7,
+    TypeByteArray = 8,
+    TypeRemove = 9,
+};
+
+// 批量写入的记录头，其后紧跟 key 和变长 value 的字节，整条记录按 8 字节对齐
+// 定长类型的值直接存放在 value 中；String/ByteArray 的 value 为字节长度
+struct BatchRecordHeader {
+    uint32_t type;
+    uint32_t keySize;
+    uint64_t value;
+};
+
+template<typename T>
+static T fromBits(const uint64_t bits) {
+    T value;
+    memcpy(&value, &bits, sizeof(T));
+    return value;
+}
+
+template<typename T>
+static uint64_t toBits(const T value) {
+    uint64_t bits = 0;
+    memcpy(&bits, &value, sizeof(T));
+    return bits;
+}
+
+static bool applyBatchRecordValue(MMKV *mmkv, const BatchRecordHeader &header, const string &key, const char *data) {
+    switch (header.type) {
+        case TypeBoolean:
+            return mmkv->set(header.value != 0, key);
+        case TypeInt:
+            return mmkv->set(static_cast<int32_t>(header.value), key);
+        case TypeUInt:
+            return mmkv->set(static_cast<uint32_t>(header.value), key);
+        case TypeLong:
+            return mmkv->set(static_cast<int64_t>(header.value), key);
+        case TypeULong:
+            return mmkv->set(header.value, key);
+        case TypeFloat:
+            return mmkv->set(fromBits<float>(header.value), key);
+        case TypeDouble:
+            return mmkv->set(fromBits<double>(header.value), key);
+        case TypeString:
+            return mmkv->set(string(data, header.value), key);
+        case TypeByteArray: {
+            const auto buffer = MMBuffer(const_cast<char *>(data), header.value, MMBufferNoCopy);
+            return mmkv->set(buffer, key);
+        }
+        default:
+            return false;
+    }
+}
+
+static bool applyBatchRecord(MMKV *mmkv, const BatchRecordHeader &header, const string &key, const char *data) {
+    // 与逐个 removeValueForKey 一致，key 不存在也算删除成功
+    if (header.type == TypeRemove) {
+        if (mmkv->removeValueForKey(key)) {
+            notifyChange(mmkv, &key);
+        }
+        return true;
+    }
+    if (!applyBatchRecordValue(mmkv, header, key, data)) {
+        return false;
+    }
+    notifyChange(mmkv, &key);
+    return true;
+}
+
+// 写后队列：开启后该实例的写入先进入无锁 MPSC 队列立即返回，由后台线程合并同一 key 的重复写入后批量落盘。
+// 本进程内的读取与其余修改操作会先等待队列写完，保证读到自己的写入
+struct PendingWrite {
+    PendingWrite *next;
+    NativeValueType type;
+    string key;
+    uint64_t value; // 定长值的位表示
+    string data;    // String/ByteArray 的字节
+};
+
+class WriteBehindQueue final : public enable_shared_from_this<WriteBehindQueue> {
+public:
+    explicit WriteBehindQueue(MMKV *mmkv) : m_mmkv(mmkv) {}
+
+    ~WriteBehindQueue() {
+        freeWrites(m_head.exchange(nullptr));
+    }
+
+    // 可由任意线程调用；队列由空变为非空时安排一次后台写入
+    void push(PendingWrite *write) {
+        m_pending.fetch_add(1, memory_order_relaxed);
+        auto head = m_head.load(memory_order_relaxed);
+        do {
+            write->next = head;
+        } while (!m_head.compare_exchange_weak(head, write, memory_order_release, memory_order_relaxed));
+        if (head == nullptr) {
+            scheduleDrain(shared_from_this());
+        }
+    }
+
+    bool hasPending() const {
+        return m_pending.load(memory_order_acquire) != 0;
+    }
+
+    // 取出当前所有待写入项，同一 key 只保留最新的一次，在一次跨进程锁内写入
+    void drain() {
+        lock_guard lock(m_drainMutex);
+        const auto writes = m_head.exchange(nullptr, memory_order_acquire);
+        if (writes == nullptr) {
+            return;
+        }
+        // 链表为由新到旧的顺序
+        size_t taken = 0;
+        unordered_set<string_view> seen;
+        vector<const PendingWrite *> latest;
+        for (auto write = writes; write != nullptr; write = write->next) {
+            taken++;
+            if (seen.insert(write->key).second) {
+                latest.push_back(write);
+            }
+        }
+        // 持有 m_drainMutex 期间不能 upcall，否则回调中读取本实例会等待这把锁，日志延后投递
+        DeferUpcallScope scope;
+        const StatsScope stats(m_mmkv, StatsScope::Maintenance);
+        {
+            const InstanceLock lock(m_mmkv, InstanceLock::Exclusive);
+            for (auto it = latest.rbegin(); it != latest.rend(); ++it) {
+                const auto write = *it;
+                const auto isVariable = write->type == TypeString || write->type == TypeByteArray;
+                const BatchRecordHeader header{
+                    write->type,
+                    static_cast<uint32_t>(write->key.size()),
+                    isVariable ? write->data.size() : write->value
+                };
+                if (!applyBatchRecord(m_mmkv, header, write->key, write->data.data())) {
+                    m_failed.store(true, memory_order_relaxed);
+                }
+            }
+        }
+        freeWrites(writes);
+        m_pending.fetch_sub(taken, memory_order_release);
+    }
+
+    // 等待调用之前入队的写入全部落盘，返回自上次 flush 以来的写入是否全部成功
+    bool flush() {
+        drain();
+        return !m_failed.exchange(false, memory_order_relaxed);
+    }
+
+private:
+    static void freeWrites(const PendingWrite *write) {
+        while (write != nullptr) {
+            const auto next = write->next;
+            delete write;
+            write = next;
+        }
+    }
+
+    static void scheduleDrain(shared_ptr<WriteBehindQueue> queue);
+
+    MMKV *const m_mmkv;
+    atomic<PendingWrite *> m_head{nullptr};
+    atomic<size_t> m_pending{0};
+    atomic<bool> m_failed{false};
+    mutex m_drainMutex;
+};
+
+static mutex g_drainRequestMutex;
+static condition_variable g_drainRequestCondition;
+static deque<shared_ptr<WriteBehindQueue>> g_drainRequests;
+static bool g_drainThreadStarted = false;
+
+void WriteBehindQueue::scheduleDrain(shared_ptr<WriteBehindQueue> queue) {
+    lock_guard lock(g_drainRequestMutex);
+    g_drainRequests.push_back(std::move(queue));
+    if (!g_drainThreadStarted) {
+        g_drainThreadStarted = true;
+        thread([] {
+            unique_lock lock(g_drainRequestMutex);
+            while (true) {
+                g_drainRequestCondition.wait(lock, [] { return !g_drainRequests.empty(); });
+                const auto request = std::move(g_drainRequests.front());
+                g_drainRequests.pop_front();
+                lock.unlock();
+                request->drain();
+                lock.lock();
+            }
+        }).detach();
+    }
+    g_drainRequestCondition.notify_one();
+}
+
+static shared_mutex g_writeBehindQueuesMutex;
+static unordered_map<const MMKV *, shared_ptr<WriteBehindQueue>> g_writeBehindQueues;
+static atomic<size_t> g_writeBehindCount{0};
+
+// 没有任何实例开启写后模式时只有一次原子读
+static shared_ptr<WriteBehindQueue> writeBehindQueue(const MMKV *mmkv) {
+    if (g_writeBehindCount.load(memory_order_acquire) == 0) {
+        return nullptr;
+    }
+    shared_lock lock(g_writeBehindQueuesMutex);
+    const auto it = g_writeBehindQueues.find(mmkv);
+    return it != g_writeBehindQueues.end() ? it->second : nullptr;
+}
+
+static void drainWriteBehind(const MMKV *mmkv) {
+    if (const auto queue = writeBehindQueue(mmkv); queue && queue->hasPending()) {
+        queue->drain();
+    }
+}
+
+static void flushMergedCounters(const MMKV *mmkv);
+
+// 读取以及不经过队列的修改操作之前调用，等待本实例已入队的写入与合并计数的增量落盘
+static void writeBarrier(const MMKV *mmkv) {
+    touchInstance(mmkv);
+    drainWriteBehind(mmkv);
+    flushMergedCounters(mmkv);
+}
+
+static bool enqueueWrite(const MMKV *mmkv, const NativeValueType type, const string &key, const uint64_t value,
+                         const void *data = nullptr, const size_t size = 0) {
+    const auto queue = writeBehindQueue(mmkv);
+    if (queue == nullptr) {
+        return false;
+    }
+    queue->push(new PendingWrite{nullptr, type, key, value, string(static_cast<const char *>(data), size)});
+    return true;
+}
+
+// 以下 write* 在写后模式下入队并返回 true，否则同步写入；入队也算一次访问，只写不读的实例不会被内存预算当作空闲
+template<typename T>
+static bool writeValue(MMKV *mmkv, const NativeValueType type, const string &key, const T value) {
+    touchInstance(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Write);
+    if (enqueueWrite(mmkv, type, key, toBits(value))) {
+        return true;
+    }
+    const InstanceLock lock(mmkv, InstanceLock::Write);
+    return notifyIf(mmkv->set(value, key), mmkv, key);
+}
+
+static bool writeString(MMKV *mmkv, const string &key, const char *value, const size_t size) {
+    touchInstance(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Write);
+    if (enqueueWrite(mmkv, TypeString, key, 0, value, size)) {
+        return true;
+    }
+    const InstanceLock lock(mmkv, InstanceLock::Write);
+    return notifyIf(mmkv->set(string(value, size), key), mmkv, key);
+}
+
+static bool writeByteArray(MMKV *mmkv, const string &key, uint8_t *value, const size_t size) {
+    touchInstance(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Write);
+    if (enqueueWrite(mmkv, TypeByteArray, key, 0, value, size)) {
+        return true;
+    }
+    const InstanceLock lock(mmkv, InstanceLock::Write);
+    const auto buffer = MMBuffer(value, size, MMBufferNoCopy);
+    return notifyIf(mmkv->set(buffer, key), mmkv, key);
+}
+
+static bool removeValue(MMKV *mmkv, const string &key) {
+    touchInstance(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Write);
+    if (enqueueWrite(mmkv, TypeRemove, key, 0)) {
+        return true;
+    }
+    const InstanceLock lock(mmkv, InstanceLock::Write);
+    return notifyIf(mmkv->removeValueForKey(key), mmkv, key);
+}
+
+// 开启或关闭写后模式，关闭时先写完已入队的写入
+extern "C" void mmkv_enableWriteBehind(MMKV *mmkv, const bool enable) {
+    shared_ptr<WriteBehindQueue> removed;
+    {
+        unique_lock lock(g_writeBehindQueuesMutex);
+        if (const auto it = g_writeBehindQueues.find(mmkv); it != g_writeBehindQueues.end()) {
+            if (enable) {
+                return;
+            }
+            removed = std::move(it->second);
+            g_writeBehindQueues.erase(it);
+            g_writeBehindCount.fetch_sub(1, memory_order_release);
+        } else if (enable) {
+            g_writeBehindQueues.emplace(mmkv, make_shared<WriteBehindQueue>(mmkv));
+            g_writeBehindCount.fetch_add(1, memory_order_release);
+        }
+    }
+    if (removed != nullptr) {
+        removed->flush();
+    }
+}
+
+// 写后模式的屏障：等待调用之前入队的写入全部落盘，返回自上次 flush 以来的写入是否全部成功；
+// 未开启写后模式时直接返回 true
+extern "C" bool mmkv_flush(MMKV *mmkv) {
+    if (const auto queue = writeBehindQueue(mmkv)) {
+        return queue->flush();
+    }
+    return true;
+}
+
+extern "C" int getInt(MMKV *mmkv, const char *key, const int defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    return mmkv->getInt32(key, defaultValue);
+}
+
+extern "C" bool setInt(MMKV *mmkv, const char *key, const int value) {
+    return writeValue(mmkv, TypeInt, key, value);
+}
+
+// String
+extern "C" const char *getString(MMKV *mmkv, const char *key, const char *defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    if (string tmp; mmkv->getString(key, tmp)) {
+        return stringToChar(tmp);
+    }
+    return stringToChar(string(defaultValue));
+}
+
+extern "C" bool setString(MMKV *mmkv, const char *key, const char *value) {
+    return writeString(mmkv, key, value, strlen(value));
+}
+
+// 按显式长度写入 UTF-8 字符串，value 可包含内嵌的 '\0'
+extern "C" bool mmkv_setStringWithLength(MMKV *mmkv, const char *key, const char *value, const size_t size) {
+    return writeString(mmkv, key, value, size);
+}
+
+// Float
+extern "C" float getFloat(MMKV *mmkv, const char *key, const float defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    return mmkv->getFloat(key, defaultValue);
+}
+
+extern "C" bool setFloat(MMKV *mmkv, const char *key, const float value) {
+    return writeValue(mmkv, TypeFloat, key, value);
+}
+
+// Long (使用 int64_t 表达 64 位整数)
+extern "C" int64_t getLong(MMKV *mmkv, const char *key, const int64_t defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    return mmkv->getInt64(key, defaultValue);
+}
+
+extern "C" bool setLong(MMKV *mmkv, const char *key, const int64_t value) {
+    return writeValue(mmkv, TypeLong, key, value);
+}
+
+// Double
+extern "C" double getDouble(MMKV *mmkv, const char *key, const double defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    return mmkv->getDouble(key, defaultValue);
+}
+
+extern "C" bool setDouble(MMKV *mmkv, const char *key, const double value) {
+    return writeValue(mmkv, TypeDouble, key, value);
+}
+
+// Boolean
+extern "C" bool getBoolean(MMKV *mmkv, const char *key, const bool defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    return mmkv->getBool(key, defaultValue);
+}
+
+extern "C" bool setBoolean(MMKV *mmkv, const char *key, const bool value) {
+    return writeValue(mmkv, TypeBoolean, key, value);
+}
+
+// ByteArray
+extern "C" uint8_t *getByteArray(MMKV *mmkv, const char *key, size_t *size) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    if (MMBuffer buffer; mmkv->getBytes(key, buffer)) {
+        *size = buffer.length();
+        const auto data = static_cast<uint8_t *>(malloc(*size));
+        if (data == nullptr) {
+            return nullptr; // 内存分配失败
+        }
+        memcpy(data, buffer.getPtr(), *size);
+        return data;
+    }
+    return nullptr;
+}
+
+extern "C" bool setByteArray(MMKV *mmkv, const char *key, uint8_t *value, const size_t size) {
+    return writeByteArray(mmkv, key, value, size);
+}
+
+// 带 key 长度的定长类型读写，免去 strlen
+extern "C" int mmkv_getInt(MMKV *mmkv, const char *key, const size_t keySize, const int defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    return mmkv->getInt32(string(key, keySize), defaultValue);
+}
+
+extern "C" bool mmkv_setInt(MMKV *mmkv, const char *key, const size_t keySize, const int value) {
+    return writeValue(mmkv, TypeInt, string(key, keySize), value);
+}
+
+extern "C" uint32_t mmkv_getUInt(MMKV *mmkv, const char *key, const size_t keySize, const uint32_t defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    return mmkv->getUInt32(string(key, keySize), defaultValue);
+}
+
+extern "C" bool mmkv_setUInt(MMKV *mmkv, const char *key, const size_t keySize, const uint32_t value) {
+    return writeValue(mmkv, TypeUInt, string(key, keySize), value);
+}
+
+extern "C" int64_t mmkv_getLong(MMKV *mmkv, const char *key, const size_t keySize, const int64_t defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    return mmkv->getInt64(string(key, keySize), defaultValue);
+}
+
+extern "C" bool mmkv_setLong(MMKV *mmkv, const char *key, const size_t keySize, const int64_t value) {
+    return writeValue(mmkv, TypeLong, string(key, keySize), value);
+}
+
+extern "C" uint64_t mmkv_getULong(MMKV *mmkv, const char *key, const size_t keySize, const uint64_t defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    return mmkv->getUInt64(string(key, keySize), defaultValue);
+}
+
+extern "C" bool mmkv_setULong(MMKV *mmkv, const char *key, const size_t keySize, const uint64_t value) {
+    return writeValue(mmkv, TypeULong, string(key, keySize), value);
+}
+
+extern "C" float mmkv_getFloat(MMKV *mmkv, const char *key, const size_t keySize, const float defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    return mmkv->getFloat(string(key, keySize), defaultValue);
+}
+
+extern "C" bool mmkv_setFloat(MMKV *mmkv, const char *key, const size_t keySize, const float value) {
+    return writeValue(mmkv, TypeFloat, string(key, keySize), value);
+}
+
+extern "C" double mmkv_getDouble(MMKV *mmkv, const char *key, const size_t keySize, const double defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    return mmkv->getDouble(string(key, keySize), defaultValue);
+}
+
+extern "C" bool mmkv_setDouble(MMKV *mmkv, const char *key, const size_t keySize, const double value) {
+    return writeValue(mmkv, TypeDouble, string(key, keySize), value);
+}
+
+extern "C" bool mmkv_getBoolean(MMKV *mmkv, const char *key, const size_t keySize, const bool defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    return mmkv->getBool(string(key, keySize), defaultValue);
+}
+
+extern "C" bool mmkv_setBoolean(MMKV *mmkv, const char *key, const size_t keySize, const bool value) {
+    return writeValue(mmkv, TypeBoolean, string(key, keySize), value);
+}
+
+// Atomic：读-改-写在一次调用内完成，省去 get/set 两次往返，也不会在线程间或进程间丢失更新。
+// 本进程内按 key 分段加锁，跨进程由 InstanceLock::Exclusive 互斥；只保证读-改-写操作之间的原子性，
+// 与同一 key 上并发的普通 set 之间不保证
+static constexpr size_t ATOMIC_STRIPE_COUNT = 64;
+static mutex g_atomicStripes[ATOMIC_STRIPE_COUNT];
+
+// 与实例锁同时持有时总是先取分段锁
+static mutex &atomicStripe(const MMKV *mmkv, const string &key) {
+    return g_atomicStripes[(hash<string>()(key) ^ hash<const MMKV *>()(mmkv)) % ATOMIC_STRIPE_COUNT];
+}
+
+template<typename T>
+static T readValue(MMKV *mmkv, const string &key, const T defaultValue, bool *hasValue) {
+    if constexpr (is_same_v<T, bool>) {
+        return mmkv->getBool(key, defaultValue, hasValue);
+    } else if constexpr (is_same_v<T, int32_t>) {
+        return mmkv->getInt32(key, defaultValue, hasValue);
+    } else if constexpr (is_same_v<T, uint32_t>) {
+        return mmkv->getUInt32(key, defaultValue, hasValue);
+    } else if constexpr (is_same_v<T, int64_t>) {
+        return mmkv->getInt64(key, defaultValue, hasValue);
+    } else if constexpr (is_same_v<T, uint64_t>) {
+        return mmkv->getUInt64(key, defaultValue, hasValue);
+    } else if constexpr (is_same_v<T, float>) {
+        return mmkv->getFloat(key, defaultValue, hasValue);
+    } else {
+        static_assert(is_same_v<T, double>);
+        return mmkv->getDouble(key, defaultValue, hasValue);
+    }
+}
+
+// 调用方需持有 key 的分段锁与实例锁；溢出时按补码回绕。写入失败时返回原值
+template<typename T>
+static T addLocked(MMKV *mmkv, const string &key, const T delta, const T defaultValue) {
+    using Unsigned = make_unsigned_t<T>;
+    const T current = readValue(mmkv, key, defaultValue, nullptr);
+    const T value = static_cast<T>(static_cast<Unsigned>(current) + static_cast<Unsigned>(delta));
+    return notifyIf(mmkv->set(value, key), mmkv, key) ? value : current;
+}
+
+template<typename T>
+static T addValue(MMKV *mmkv, const string &key, const T delta, const T defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Write);
+    const lock_guard stripe(atomicStripe(mmkv, key));
+    const InstanceLock lock(mmkv, InstanceLock::Exclusive);
+    return addLocked(mmkv, key, delta, defaultValue);
+}
+
+// 当前值与 expected 按位相等时写入 value；key 不存在时不写入
+template<typename T>
+static bool compareAndSet(MMKV *mmkv, const string &key, const T expected, const T value) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Write);
+    const lock_guard stripe(atomicStripe(mmkv, key));
+    const InstanceLock lock(mmkv, InstanceLock::Exclusive);
+    bool hasValue = false;
+    const T current = readValue(mmkv, key, expected, &hasValue);
+    if (!hasValue || toBits(current) != toBits(expected)) {
+        return false;
+    }
+    return notifyIf(mmkv->set(value, key), mmkv, key);
+}
+
+// 将 key 的值加上 delta 并返回新值，key 不存在时以 defaultValue 为原值
+extern "C" int32_t mmkv_addInt32(MMKV *mmkv, const char *key, const size_t keySize, const int32_t delta,
+                                 const int32_t defaultValue) {
+    return addValue(mmkv, string(key, keySize), delta, defaultValue);
+}
+
+extern "C" int64_t mmkv_addInt64(MMKV *mmkv, const char *key, const size_t keySize, const int64_t delta,
+                                 const int64_t defaultValue) {
+    return addValue(mmkv, string(key, keySize), delta, defaultValue);
+}
+
+extern "C" bool mmkv_compareAndSetInt(MMKV *mmkv, const char *key, const size_t keySize, const int32_t expected,
+                                      const int32_t value) {
+    return compareAndSet(mmkv, string(key, keySize), expected, value);
+}
+
+extern "C" bool mmkv_compareAndSetUInt(MMKV *mmkv, const char *key, const size_t keySize, const uint32_t expected,
+                                       const uint32_t value) {
+    return compareAndSet(mmkv, string(key, keySize), expected, value);
+}
+
+extern "C" bool mmkv_compareAndSetLong(MMKV *mmkv, const char *key, const size_t keySize, const int64_t expected,
+                                       const int64_t value) {
+    return compareAndSet(mmkv, string(key, keySize), expected, value);
+}
+
+extern "C" bool mmkv_compareAndSetULong(MMKV *mmkv, const char *key, const size_t keySize, const uint64_t expected,
+                                        const uint64_t value) {
+    return compareAndSet(mmkv, string(key, keySize), expected, value);
+}
+
+extern "C" bool mmkv_compareAndSetFloat(MMKV *mmkv, const char *key, const size_t keySize, const float expected,
+                                        const float value) {
+    return compareAndSet(mmkv, string(key, keySize), expected, value);
+}
+
+extern "C" bool mmkv_compareAndSetDouble(MMKV *mmkv, const char *key, const size_t keySize, const double expected,
+                                         const double value) {
+    return compareAndSet(mmkv, string(key, keySize), expected, value);
+}
+
+extern "C" bool mmkv_compareAndSetBoolean(MMKV *mmkv, const char *key, const size_t keySize, const bool expected,
+                                          const bool value) {
+    return compareAndSet(mmkv, string(key, keySize), expected, value);
+}
+
+// 合并计数：开启后 mmkv_addInt64Merged 只在内存中累加增量，由后台线程按间隔在实例锁内写入，
+// 高频计数每个周期每个 key 只写一次。本进程内的读取与其余操作之前会先写入累积的增量，
+// 进程在写入前退出时丢失未写入的增量
+class MergedCounters final {
+public:
+    MergedCounters(MMKV *mmkv, const chrono::milliseconds interval)
+        : m_mmkv(mmkv), m_interval(interval), m_lastFlush(chrono::steady_clock::now()) {}
+
+    void add(const string &key, const int64_t delta) {
+        lock_guard lock(m_mutex);
+        m_deltas[key] += delta;
+        m_pending.fetch_add(1, memory_order_release);
+    }
+
+    bool hasPending() const {
+        return m_pending.load(memory_order_acquire) != 0;
+    }
+
+    chrono::steady_clock::time_point nextFlush() {
+        lock_guard lock(m_flushMutex);
+        return m_lastFlush + m_interval;
+    }
+
+    void flush() {
+        lock_guard flushLock(m_flushMutex);
+        m_lastFlush = chrono::steady_clock::now();
+        unordered_map<string, int64_t> deltas;
+        size_t taken;
+        {
+            lock_guard lock(m_mutex);
+            deltas.swap(m_deltas);
+            taken = m_pending.load(memory_order_relaxed);
+        }
+        if (deltas.empty()) {
+            return;
+        }
+        // 与写后队列一样，持有 m_flushMutex 期间不能 upcall
+        DeferUpcallScope scope;
+        drainWriteBehind(m_mmkv);
+        const StatsScope stats(m_mmkv, StatsScope::Maintenance);
+        for (const auto &[key, delta]: deltas) {
+            const lock_guard stripe(atomicStripe(m_mmkv, key));
+            const InstanceLock lock(m_mmkv, InstanceLock::Exclusive);
+            addLocked<int64_t>(m_mmkv, key, delta, 0);
+        }
+        m_pending.fetch_sub(taken, memory_order_release);
+    }
+
+private:
+    MMKV *const m_mmkv;
+    const chrono::milliseconds m_interval;
+    mutex m_mutex;
+    unordered_map<string, int64_t> m_deltas;
+    atomic<size_t> m_pending{0};
+    mutex m_flushMutex;
+    chrono::steady_clock::time_point m_lastFlush;
+};
+
+static shared_mutex g_mergedCountersMutex;
+static unordered_map<const MMKV *, shared_ptr<MergedCounters>> g_mergedCounters;
+static atomic<size_t> g_mergedCounterCount{0};
+
+static mutex g_counterFlushMutex;
+static condition_variable g_counterFlushCondition;
+static bool g_counterFlushThreadStarted = false;
+// 每开启一个实例加一，后台线程据此发现等待期间新开启的实例
+static uint64_t g_counterFlushGeneration = 0;
+
+static shared_ptr<MergedCounters> mergedCounters(const MMKV *mmkv) {
+    if (g_mergedCounterCount.load(memory_order_acquire) == 0) {
+        return nullptr;
+    }
+    shared_lock lock(g_mergedCountersMutex);
+    const auto it = g_mergedCounters.find(mmkv);
+    return it != g_mergedCounters.end() ? it->second : nullptr;
+}
+
+static void flushMergedCounters(const MMKV *mmkv) {
+    if (const auto counters = mergedCounters(mmkv); counters && counters->hasPending()) {
+        counters->flush();
+    }
+}
+
+static void runCounterFlush() {
+    while (true) {
+        uint64_t generation;
+        {
+            lock_guard lock(g_counterFlushMutex);
+            generation = g_counterFlushGeneration;
+        }
+        vector<shared_ptr<MergedCounters>> due;
+        auto wait = chrono::steady_clock::duration::max();
+        {
+            shared_lock lock(g_mergedCountersMutex);
+            const auto now = chrono::steady_clock::now();
+            for (const auto &[_, counters]: g_mergedCounters) {
+                if (const auto next = counters->nextFlush(); next <= now) {
+                    due.push_back(counters);
+                } else {
+                    wait = min(wait, next - now);
+                }
+            }
+        }
+        for (const auto &counters: due) {
+            counters->flush();
+        }
+        if (!due.empty()) {
+            continue;
+        }
+        unique_lock lock(g_counterFlushMutex);
+        const auto changed = [generation] { return g_counterFlushGeneration != generation; };
+        if (wait == chrono::steady_clock::duration::max()) {
+            g_counterFlushCondition.wait(lock, changed);
+        } else {
+            g_counterFlushCondition.wait_for(lock, wait, changed);
+        }
+    }
+}
+
+// 开启或关闭合并计数，关闭时先写入累积的增量
+extern "C" void mmkv_enableMergedCounters(MMKV *mmkv, const bool enable, const int64_t flushMillis) {
+    shared_ptr<MergedCounters> removed;
+    {
+        unique_lock lock(g_mergedCountersMutex);
+        if (const auto it = g_mergedCounters.find(mmkv); it != g_mergedCounters.end()) {
+            if (enable) {
+                return;
+            }
+            removed = std::move(it->second);
+            g_mergedCounters.erase(it);
+            g_mergedCounterCount.fetch_sub(1, memory_order_release);
+        } else if (enable) {
+            const auto interval = chrono::milliseconds(max<int64_t>(flushMillis, 1));
+            g_mergedCounters.emplace(mmkv, make_shared<MergedCounters>(mmkv, interval));
+            g_mergedCounterCount.fetch_add(1, memory_order_release);
+        }
+    }
+    if (removed != nullptr) {
+        removed->flush();
+        return;
+    }
+    lock_guard lock(g_counterFlushMutex);
+    if (!g_counterFlushThreadStarted) {
+        g_counterFlushThreadStarted = true;
+        thread(runCounterFlush).detach();
+    }
+    g_counterFlushGeneration++;
+    g_counterFlushCondition.notify_one();
+}
+
+// 未开启合并计数时立即写入
+extern "C" void mmkv_addInt64Merged(MMKV *mmkv, const char *key, const size_t keySize, const int64_t delta) {
+    if (const auto counters = mergedCounters(mmkv)) {
+        touchInstance(mmkv);
+        counters->add(string(key, keySize), delta);
+        return;
+    }
+    addValue(mmkv, string(key, keySize), delta, int64_t(0));
+}
+
+static int64_t valueSize(MMKV *mmkv, const string &key) {
+    if (mmkv->getValueSize(key, false) == 0) {
+        return -1;
+    }
+    return static_cast<int64_t>(mmkv->getValueSize(key, true));
+}
+
+// 值的实际字节长度（String/ByteArray 不含长度前缀），key 不存在时返回 -1
+extern "C" int64_t mmkv_valueSize(MMKV *mmkv, const char *key) {
+    writeBarrier(mmkv);
+    return valueSize(mmkv, string(key));
+}
+
+// 只读取带长度前缀的值（String/ByteArray）。定长类型的值没有长度前缀，writeValueToBuffer 会原样拷贝其编码，
+// 这里与 MMKV::getString/getBytes 一样按读取失败处理，返回 -1
+static int64_t readLengthPrefixed(MMKV *mmkv, const string &key, void *dst, const size_t capacity) {
+    const auto rawSize = mmkv->getValueSize(key, false);
+    if (rawSize == 0) {
+        return -1;
+    }
+    const auto size = mmkv->getValueSize(key, true);
+    if (size >= rawSize) {
+        return -1;
+    }
+    if (size <= capacity) {
+        const auto bufferSize = static_cast<int32_t>(min<size_t>(capacity, INT32_MAX));
+        if (const auto written = mmkv->writeValueToBuffer(key, dst, bufferSize); written >= 0) {
+            return written;
+        }
+    }
+    return static_cast<int64_t>(size);
+}
+
+// 将值直接写入调用方提供的 dst，仅在 capacity 足够时写入；返回值的字节长度，key 不存在或不是 String/ByteArray 时返回 -1。
+// String 按 UTF-8 原样写入，不追加 '\0'，可包含内嵌的 '\0'
+extern "C" int64_t mmkv_readValueInto(MMKV *mmkv, const char *key, void *dst, const size_t capacity) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    return readLengthPrefixed(mmkv, string(key), dst, capacity);
+}
+
+// KeyHandle：预先构造好的 key，热点路径上免去 UTF-8 编码、strlen 与 std::string 构造
+struct KeyHandle {
+    const string key;
+};
+
+extern "C" KeyHandle *mmkv_keyHandle(const char *key, const size_t size) {
+    return new KeyHandle{string(key, size)};
+}
+
+extern "C" void mmkv_releaseKeyHandle(const KeyHandle *handle) {
+    delete handle;
+}
+
+extern "C" int getIntByHandle(MMKV *mmkv, const KeyHandle *handle, const int defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    return mmkv->getInt32(handle->key, defaultValue);
+}
+
+extern "C" bool setIntByHandle(MMKV *mmkv, const KeyHandle *handle, const int value) {
+    return writeValue(mmkv, TypeInt, handle->key, value);
 }
 
-extern "C" int getInt(MMKV *mmkv, const char *key, const int defaultValue) {
-    return mmkv->getInt32(key, defaultValue);
+extern "C" uint32_t getUIntByHandle(MMKV *mmkv, const KeyHandle *handle, const uint32_t defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    return mmkv->getUInt32(handle->key, defaultValue);
 }
 
-extern "C" bool setInt(MMKV *mmkv, const char *key, const int value) {
-    return mmkv->set(value, key);
+extern "C" bool setUIntByHandle(MMKV *mmkv, const KeyHandle *handle, const uint32_t value) {
+    return writeValue(mmkv, TypeUInt, handle->key, value);
 }
 
-// String
-extern "C" const char *getString(MMKV *mmkv, const char *key, const char *defaultValue) {
-    if (string tmp; mmkv->getString(key, tmp)) {
-        return stringToChar(tmp);
-    }
-    return stringToChar(string(defaultValue));
+extern "C" int64_t getLongByHandle(MMKV *mmkv, const KeyHandle *handle, const int64_t defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    return mmkv->getInt64(handle->key, defaultValue);
 }
 
-extern "C" bool setString(MMKV *mmkv, const char *key, const char *value) {
-    return mmkv->set(string(value), key);
+extern "C" bool setLongByHandle(MMKV *mmkv, const KeyHandle *handle, const int64_t value) {
+    return writeValue(mmkv, TypeLong, handle->key, value);
 }
 
-// Float
-extern "C" float getFloat(MMKV *mmkv, const char *key, const float defaultValue) {
-    return mmkv->getFloat(key, defaultValue);
+extern "C" uint64_t getULongByHandle(MMKV *mmkv, const KeyHandle *handle, const uint64_t defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    return mmkv->getUInt64(handle->key, defaultValue);
 }
 
-extern "C" bool setFloat(MMKV *mmkv, const char *key, const float value) {
-    return mmkv->set(value, key);
+extern "C" bool setULongByHandle(MMKV *mmkv, const KeyHandle *handle, const uint64_t value) {
+    return writeValue(mmkv, TypeULong, handle->key, value);
 }
 
-// Long (使用 int64_t 表达 64 位整数)
-extern "C" int64_t getLong(MMKV *mmkv, const char *key, const int64_t defaultValue) {
-    return mmkv->getInt64(key, defaultValue);
+extern "C" float getFloatByHandle(MMKV *mmkv, const KeyHandle *handle, const float defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    return mmkv->getFloat(handle->key, defaultValue);
 }
 
-extern "C" bool setLong(MMKV *mmkv, const char *key, const int64_t value) {
-    return mmkv->set(value, key);
+extern "C" bool setFloatByHandle(MMKV *mmkv, const KeyHandle *handle, const float value) {
+    return writeValue(mmkv, TypeFloat, handle->key, value);
 }
 
-// Double
-extern "C" double getDouble(MMKV *mmkv, const char *key, const double defaultValue) {
-    return mmkv->getDouble(key, defaultValue);
+extern "C" double getDoubleByHandle(MMKV *mmkv, const KeyHandle *handle, const double defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    return mmkv->getDouble(handle->key, defaultValue);
 }
 
-extern "C" bool setDouble(MMKV *mmkv, const char *key, const double value) {
-    return mmkv->set(value, key);
+extern "C" bool setDoubleByHandle(MMKV *mmkv, const KeyHandle *handle, const double value) {
+    return writeValue(mmkv, TypeDouble, handle->key, value);
 }
 
-// Boolean
-extern "C" bool getBoolean(MMKV *mmkv, const char *key, const bool defaultValue) {
-    return mmkv->getBool(key, defaultValue);
+extern "C" bool getBooleanByHandle(MMKV *mmkv, const KeyHandle *handle, const bool defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    return mmkv->getBool(handle->key, defaultValue);
 }
 
-extern "C" bool setBoolean(MMKV *mmkv, const char *key, const bool value) {
-    return mmkv->set(value, key);
+extern "C" bool setBooleanByHandle(MMKV *mmkv, const KeyHandle *handle, const bool value) {
+    return writeValue(mmkv, TypeBoolean, handle->key, value);
 }
 
-// ByteArray
-extern "C" uint8_t *getByteArray(MMKV *mmkv, const char *key, size_t *size) {
-    if (MMBuffer buffer; mmkv->getBytes(key, buffer)) {
-        *size = buffer.length();
-        const auto data = static_cast<uint8_t *>(malloc(*size));
-        if (data == nullptr) {
-            return nullptr; // 内存分配失败
-        }
-        memcpy(data, buffer.getPtr(), *size);
-        return data;
-    }
-    return nullptr;
+extern "C" bool setStringByHandle(MMKV *mmkv, const KeyHandle *handle, const char *value, const size_t size) {
+    return writeString(mmkv, handle->key, value, size);
 }
 
-extern "C" bool setByteArray(MMKV *mmkv, const char *key, uint8_t *value, const size_t size) {
-    const auto buffer = MMBuffer(value, size, MMBufferNoCopy);
-    return mmkv->set(buffer, key);
+extern "C" bool setByteArrayByHandle(MMKV *mmkv, const KeyHandle *handle, uint8_t *value, const size_t size) {
+    return writeByteArray(mmkv, handle->key, value, size);
+}
+
+// 语义同 mmkv_readValueInto
+extern "C" int64_t mmkv_readValueIntoByHandle(MMKV *mmkv, const KeyHandle *handle, void *dst, const size_t capacity) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    return readLengthPrefixed(mmkv, handle->key, dst, capacity);
+}
+
+extern "C" bool mmkv_removeValueByHandle(MMKV *mmkv, const KeyHandle *handle) {
+    return removeValue(mmkv, handle->key);
+}
+
+extern "C" bool mmkv_containsKeyByHandle(MMKV *mmkv, const KeyHandle *handle) {
+    writeBarrier(mmkv);
+    return mmkv->containsKey(handle->key);
 }
 
 // StringList
@@ -153,25 +1924,91 @@ struct StringListReturn {
     size_t size;
 };
 
+static size_t alignTo8(const size_t size) {
+    return (size + 7) & ~static_cast<size_t>(7);
+}
+
+// 紧凑的字符串列表，只占一块内存：count(u64) | offsets(u64 × (count + 1)) | 字节数据，
+// 第 i 个字符串为数据区中的 [offsets[i], offsets[i + 1])，不以 '\0' 结尾
+static size_t packedHeaderSize(const size_t count) {
+    return sizeof(uint64_t) * (count + 2);
+}
+
+// 返回由 malloc 分配的紧凑列表（由调用方负责释放），size 为总字节数；
+// trailerSize 不为 0 时在数据区之后按 8 字节对齐额外预留该大小的空间
+static uint8_t *packStringList(const vector<string> &list, size_t *size, const size_t trailerSize = 0) {
+    size_t dataSize = 0;
+    for (const auto &item: list) {
+        dataSize += item.size();
+    }
+    const auto headerSize = packedHeaderSize(list.size());
+    *size = trailerSize == 0 ? headerSize + dataSize : alignTo8(headerSize + dataSize) + trailerSize;
+    const auto packed = static_cast<uint8_t *>(malloc(*size));
+    if (packed == nullptr) {
+        return nullptr;
+    }
+    const auto offsets = reinterpret_cast<uint64_t *>(packed);
+    offsets[0] = list.size();
+    uint64_t offset = 0;
+    for (size_t i = 0; i < list.size(); i++) {
+        offsets[i + 1] = offset;
+        memcpy(packed + headerSize + offset, list[i].data(), list[i].size());
+        offset += list[i].size();
+    }
+    offsets[list.size() + 1] = offset;
+    return packed;
+}
+
+static bool unpackStringList(const uint8_t *packed, const size_t size, vector<string> &list) {
+    if (packed == nullptr || size < packedHeaderSize(0)) {
+        return false;
+    }
+    uint64_t count = 0;
+    memcpy(&count, packed, sizeof(count));
+    if (count > size / sizeof(uint64_t) || packedHeaderSize(count) > size) {
+        return false;
+    }
+    const auto headerSize = packedHeaderSize(count);
+    const auto dataSize = size - headerSize;
+    const auto data = reinterpret_cast<const char *>(packed + headerSize);
+    list.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        uint64_t begin = 0, end = 0;
+        memcpy(&begin, packed + sizeof(uint64_t) * (i + 1), sizeof(begin));
+        memcpy(&end, packed + sizeof(uint64_t) * (i + 2), sizeof(end));
+        if (begin > end || end > dataSize) {
+            return false;
+        }
+        list.emplace_back(data + begin, end - begin);
+    }
+    return true;
+}
+
 // UInt
 extern "C" uint32_t getUInt(MMKV *mmkv, const char *key, const uint32_t defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
     return mmkv->getUInt32(key, defaultValue);
 }
 
 extern "C" bool setUInt(MMKV *mmkv, const char *key, const uint32_t value) {
-    return mmkv->set(value, key);
+    return writeValue(mmkv, TypeUInt, key, value);
 }
 
 // ULong
 extern "C" uint64_t getULong(MMKV *mmkv, const char *key, const uint64_t defaultValue) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
     return mmkv->getUInt64(key, defaultValue);
 }
 
 extern "C" bool setULong(MMKV *mmkv, const char *key, const uint64_t value) {
-    return mmkv->set(value, key);
+    return writeValue(mmkv, TypeULong, key, value);
 }
 
 extern "C" StringListReturn *getStringSet(MMKV *mmkv, const char *key) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
     if (vector<string> vec; mmkv->getVector(key, vec)) {
         const auto rtn = static_cast<StringListReturn *>(malloc(sizeof(StringListReturn)));
         if (rtn == nullptr) {
@@ -201,6 +2038,9 @@ extern "C" StringListReturn *getStringSet(MMKV *mmkv, const char *key) {
 }
 
 extern "C" bool setStringSet(MMKV *mmkv, const char *key, const char **value, const size_t size) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Write);
+    const InstanceLock lock(mmkv, InstanceLock::Write);
     if (value) {
         vector<string> vec;
         vec.reserve(size);
@@ -209,49 +2049,624 @@ extern "C" bool setStringSet(MMKV *mmkv, const char *key, const char **value, co
                 vec.emplace_back(value[i]);
             }
         }
-        return mmkv->set(vec, key);
+        return notifyIf(mmkv->set(vec, key), mmkv, key);
+    }
+    return notifyIf(mmkv->removeValueForKey(key), mmkv, key);
+}
+
+// 以紧凑格式返回字符串集合，key 不存在时返回 nullptr
+extern "C" uint8_t *mmkv_getStringSetPacked(MMKV *mmkv, const char *key, size_t *size) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Read);
+    if (vector<string> vec; mmkv->getVector(key, vec)) {
+        return packStringList(vec, size);
+    }
+    return nullptr;
+}
+
+// packed 为紧凑格式的字符串集合，为 nullptr 时移除该 key
+extern "C" bool mmkv_setStringSetPacked(MMKV *mmkv, const char *key, const uint8_t *packed, const size_t size) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Write);
+    const InstanceLock lock(mmkv, InstanceLock::Write);
+    if (packed == nullptr) {
+        return notifyIf(mmkv->removeValueForKey(key), mmkv, key);
+    }
+    if (vector<string> vec; unpackStringList(packed, size, vec)) {
+        return notifyIf(mmkv->set(vec, key), mmkv, key);
+    }
+    return false;
+}
+
+// Batch
+// 依次写入 count 条记录，调用方需持有 InstanceLock::Exclusive；返回成功写入的条数，记录格式非法时返回 -1。
+// 跳过前 from 条，每写完一条以已处理的条数调用 onApplied
+template<typename OnApplied>
+static int64_t applyBatchRecords(MMKV *mmkv, const uint8_t *records, const size_t size, const size_t count,
+                                 const size_t from, OnApplied &&onApplied) {
+    int64_t succeeded = 0;
+    size_t offset = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (offset + sizeof(BatchRecordHeader) > size) {
+            succeeded = -1;
+            break;
+        }
+        BatchRecordHeader header{};
+        memcpy(&header, records + offset, sizeof(header));
+        const auto key = reinterpret_cast<const char *>(records + offset + sizeof(header));
+        const size_t dataSize = header.type == TypeString || header.type == TypeByteArray ? header.value : 0;
+        const size_t recordSize = alignTo8(sizeof(header) + header.keySize + dataSize);
+        if (dataSize > size || offset + recordSize > size) {
+            succeeded = -1;
+            break;
+        }
+        offset += recordSize;
+        if (i < from) {
+            continue;
+        }
+        if (applyBatchRecord(mmkv, header, string(key, header.keySize), key + header.keySize)) {
+            succeeded++;
+        }
+        onApplied(i + 1);
+    }
+    return succeeded;
+}
+
+static int64_t applyBatchRecords(MMKV *mmkv, const uint8_t *records, const size_t size, const size_t count) {
+    return applyBatchRecords(mmkv, records, size, count, 0, [](size_t) {});
+}
+
+// 在一次跨进程锁内依次写入 count 条记录，返回成功写入的条数；记录格式非法时返回 -1
+extern "C" int64_t mmkv_setBatch(MMKV *mmkv, const uint8_t *records, const size_t size, const size_t count) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Maintenance);
+    if (records == nullptr || count == 0) {
+        return 0;
+    }
+    const InstanceLock lock(mmkv, InstanceLock::Exclusive);
+    return applyBatchRecords(mmkv, records, size, count);
+}
+
+// Transaction：在 native 侧暂存多条写入，提交时先把整批记录原地写入 <root>/.txn/<hash> 日志并落盘一次，
+// 再在一次跨进程锁内应用。日志记下应用前实例的 actualSize，每应用一条原地更新进度（不落盘）；
+// 中途进程退出时，下次打开或提交只在 actualSize 仍与进度一致、即之后没有其他写入时接着重放剩余记录，
+// 否则丢弃日志，避免用旧记录覆盖更新的写入。其他进程的读取在提交期间等待 MMKV 文件锁，
+// 不会看到写了一半的状态。加密实例的日志以实例密钥加密
+struct MMKVTransaction {
+    MMKV *mmkv;
+    vector<uint8_t> records; // 与 mmkv_setBatch 相同的格式
+    size_t count;
+};
+
+// 日志文件头，其后紧跟进度与 size 字节的记录；文件复用，尾部可能残留更早提交的字节
+struct TransactionJournalHeader {
+    uint32_t magic;
+    uint32_t encrypted;
+    uint64_t count;
+    uint64_t size;
+    uint32_t crc; // 记录明文的 CRC-32，校验失败说明日志未写完，此时记录尚未应用，直接丢弃
+    uint32_t reserved;
+    uint8_t iv[AesCfb128::BLOCK_SIZE];
+};
+
+// 应用进度，随每条记录原地更新；pending 为 0 时日志已无待应用的记录
+struct TransactionJournalProgress {
+    uint64_t pending;
+    uint64_t applied;    // 已应用的记录数
+    uint64_t actualSize; // 应用完 applied 条后实例的 actualSize
+};
+
+static constexpr uint32_t TRANSACTION_JOURNAL_MAGIC = 0x324e5854; // "TXN2"
+
+class TransactionJournal final {
+public:
+    explicit TransactionJournal(string path) : path(std::move(path)) {}
+
+    ~TransactionJournal() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    TransactionJournal(const TransactionJournal &) = delete;
+    TransactionJournal &operator=(const TransactionJournal &) = delete;
+
+    const string path;
+    // 本进程内串行提交与重放，跨进程由 InstanceLock::Exclusive 串行；先取它再取实例锁
+    mutex commitMutex;
+    // 日志文件的描述符，持有 commitMutex 时访问；第一次提交时创建文件
+    int fd = -1;
+};
+
+static mutex g_journalsMutex;
+static unordered_map<const MMKV *, shared_ptr<TransactionJournal>> g_journals;
+
+// rootPath 只在实例第一次用到日志时生效，以 mmkv_mmkvWithID 打开时传入的为准
+static shared_ptr<TransactionJournal> transactionJournal(const MMKV *mmkv, const char *rootPath = nullptr) {
+    lock_guard lock(g_journalsMutex);
+    auto &journal = g_journals[mmkv];
+    if (journal == nullptr) {
+        const MMKVPath_t root = rootPath != nullptr ? MMKVPath_t(rootPath) : MMKV::getRootDir();
+        journal = make_shared<TransactionJournal>(root + "/.txn/" + hashName(mmkv->mmapID()));
+    }
+    return journal;
+}
+
+static bool preadAll(const int fd, void *data, size_t size, off_t offset) {
+    auto bytes = static_cast<uint8_t *>(data);
+    while (size > 0) {
+        const auto count = pread(fd, bytes, size, offset);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        bytes += count;
+        size -= static_cast<size_t>(count);
+        offset += count;
+    }
+    return true;
+}
+
+static bool pwriteAll(const int fd, const void *data, size_t size, off_t offset) {
+    auto bytes = static_cast<const uint8_t *>(data);
+    while (size > 0) {
+        const auto written = pwrite(fd, bytes, size, offset);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+        offset += written;
+    }
+    return true;
+}
+
+// 打开日志文件，create 为 false 且文件不存在时返回 false；新建时落盘一次所在目录，之后的提交不再涉及目录
+static bool openJournal(TransactionJournal &journal, const bool create) {
+    if (journal.fd >= 0) {
+        return true;
+    }
+    journal.fd = open(journal.path.c_str(), O_RDWR | O_CLOEXEC);
+    if (journal.fd >= 0 || !create) {
+        return journal.fd >= 0;
+    }
+    const auto dir = filesystem::path(journal.path).parent_path();
+    error_code ec;
+    filesystem::create_directories(dir, ec);
+    journal.fd = open(journal.path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (journal.fd >= 0 && !syncDirectory(dir)) {
+        close(journal.fd);
+        journal.fd = -1;
+    }
+    return journal.fd >= 0;
+}
+
+// 进度只写入页缓存：进程退出后仍可见，掉电时丢失的进度会在重放时表现为 actualSize 不一致而丢弃日志
+static void writeProgress(const TransactionJournal &journal, const TransactionJournalProgress &progress) {
+    pwriteAll(journal.fd, &progress, sizeof(progress), sizeof(TransactionJournalHeader));
+}
+
+// 应用 records 中第 from 条起的记录并随之更新进度，全部应用后清除 pending
+static int64_t applyJournaled(const TransactionJournal &journal, MMKV *mmkv, const uint8_t *records,
+                              const size_t size, const size_t count, const size_t from) {
+    const auto succeeded = applyBatchRecords(mmkv, records, size, count, from, [&](const size_t applied) {
+        writeProgress(journal, {applied < count ? 1u : 0u, applied, mmkv->actualSize()});
+    });
+    if (succeeded < 0) {
+        writeProgress(journal, {0, 0, 0});
+    }
+    return succeeded;
+}
+
+// 头、进度与记录一次写入并只落盘一次，进度中记下应用前的 actualSize
+static bool writeJournal(const TransactionJournal &journal, MMKV *mmkv, const MMKVTransaction &txn) {
+    TransactionJournalHeader header{
+        TRANSACTION_JOURNAL_MAGIC, 0, txn.count, txn.records.size(),
+        crc32Dispatch(0, txn.records.data(), txn.records.size()), 0, {},
+    };
+    const TransactionJournalProgress progress{1, 0, mmkv->actualSize()};
+    vector<uint8_t> buffer(sizeof(header) + sizeof(progress) + txn.records.size());
+    const auto payload = buffer.data() + sizeof(header) + sizeof(progress);
+    if (const auto key = mmkv->cryptKey(); !key.empty()) {
+        random_device random;
+        for (auto &byte: header.iv) {
+            byte = static_cast<uint8_t>(random());
+        }
+        AesCfb128(key.data(), key.size(), header.iv, sizeof(header.iv))
+                .encrypt(txn.records.data(), payload, txn.records.size());
+        header.encrypted = 1;
+    } else if (!txn.records.empty()) {
+        memcpy(payload, txn.records.data(), txn.records.size());
+    }
+    memcpy(buffer.data(), &header, sizeof(header));
+    memcpy(buffer.data() + sizeof(header), &progress, sizeof(progress));
+    if (pwriteAll(journal.fd, buffer.data(), buffer.size(), 0) && fdatasync(journal.fd) == 0) {
+        return true;
+    }
+    // 调用方会收到失败，不能留下之后会被重放的日志
+    writeProgress(journal, {0, 0, 0});
+    return false;
+}
+
+// 接着应用上次未完成的提交，调用方需持有 commitMutex 与 InstanceLock::Exclusive。
+// 应用进度之后实例又被写过（或进度在掉电中丢失）时丢弃日志：此时无法区分哪些记录已落地，重放会覆盖更新的写入
+static void replayJournal(const TransactionJournal &journal, MMKV *mmkv) {
+    TransactionJournalHeader header{};
+    TransactionJournalProgress progress{};
+    struct stat st{};
+    if (fstat(journal.fd, &st) != 0 || !preadAll(journal.fd, &header, sizeof(header), 0) ||
+        !preadAll(journal.fd, &progress, sizeof(progress), sizeof(header)) ||
+        header.magic != TRANSACTION_JOURNAL_MAGIC || progress.pending == 0 ||
+        header.size > static_cast<uint64_t>(st.st_size) - sizeof(header) - sizeof(progress)) {
+        return;
+    }
+    if (progress.actualSize != mmkv->actualSize() || progress.applied >= header.count) {
+        g_handler.mmkvLog(MMKVLogWarning, __FILE__, __LINE__, __func__,
+                          "[" + mmkv->mmapID() + "] transaction journal is stale, discarded");
+        writeProgress(journal, {0, 0, 0});
+        return;
+    }
+    vector<uint8_t> records(header.size);
+    bool valid = preadAll(journal.fd, records.data(), records.size(), sizeof(header) + sizeof(progress));
+    if (valid && header.encrypted != 0) {
+        const auto key = mmkv->cryptKey();
+        AesCfb128(key.data(), key.size(), header.iv, sizeof(header.iv))
+                .decrypt(records.data(), records.data(), records.size());
+    }
+    if (valid && crc32Dispatch(0, records.data(), records.size()) == header.crc) {
+        applyJournaled(journal, mmkv, records.data(), records.size(), header.count, progress.applied);
+    } else {
+        writeProgress(journal, {0, 0, 0});
+    }
+}
+
+// 打开实例后调用，存在上次未完成的提交时接着应用
+static void recoverTransaction(MMKV *mmkv, const char *rootPath) {
+    const auto journal = transactionJournal(mmkv, rootPath);
+    const lock_guard commitLock(journal->commitMutex);
+    if (!openJournal(*journal, false)) {
+        return;
+    }
+    const InstanceLock lock(mmkv, InstanceLock::Exclusive);
+    replayJournal(*journal, mmkv);
+}
+
+extern "C" MMKVTransaction *mmkv_txnBegin(MMKV *mmkv) {
+    return new MMKVTransaction{mmkv, {}, 0};
+}
+
+// 暂存一条写入，type 为 NativeValueType；定长值的位表示放在 value 中，String/ByteArray 的字节放在 data 中
+extern "C" bool mmkv_txnPut(MMKVTransaction *txn, const uint32_t type, const char *key, const size_t keySize,
+                            const uint64_t value, const void *data, const size_t dataSize) {
+    if (type > TypeRemove || keySize > UINT32_MAX) {
+        return false;
+    }
+    const bool isVariable = type == TypeString || type == TypeByteArray;
+    const BatchRecordHeader header{type, static_cast<uint32_t>(keySize), isVariable ? dataSize : value};
+    const size_t offset = txn->records.size();
+    txn->records.resize(offset + alignTo8(sizeof(header) + keySize + (isVariable ? dataSize : 0)));
+    const auto out = txn->records.data() + offset;
+    memcpy(out, &header, sizeof(header));
+    memcpy(out + sizeof(header), key, keySize);
+    if (isVariable && dataSize > 0) {
+        memcpy(out + sizeof(header) + keySize, data, dataSize);
+    }
+    txn->count++;
+    return true;
+}
+
+extern "C" bool mmkv_txnRemove(MMKVTransaction *txn, const char *key, const size_t keySize) {
+    return mmkv_txnPut(txn, TypeRemove, key, keySize, 0, nullptr, 0);
+}
+
+// 提交并释放 txn，返回成功写入的条数；日志写入失败时不写入任何记录并返回 -1。
+// MMKV 仍逐条追加并更新 CRC，整批的原子性由日志保证；每次提交只有一次日志落盘
+extern "C" int64_t mmkv_txnCommit(MMKVTransaction *txn) {
+    const unique_ptr<MMKVTransaction> owner(txn);
+    const auto mmkv = txn->mmkv;
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Maintenance);
+    if (txn->count == 0) {
+        return 0;
+    }
+    const auto journal = transactionJournal(mmkv);
+    const lock_guard commitLock(journal->commitMutex);
+    if (!openJournal(*journal, true)) {
+        return -1;
+    }
+    const InstanceLock lock(mmkv, InstanceLock::Exclusive);
+    replayJournal(*journal, mmkv);
+    if (!writeJournal(*journal, mmkv, *txn)) {
+        return -1;
+    }
+    return applyJournaled(*journal, mmkv, txn->records.data(), txn->records.size(), txn->count, 0);
+}
+
+// 丢弃未提交的 txn
+extern "C" void mmkv_txnAbort(const MMKVTransaction *txn) {
+    delete txn;
+}
+
+// 批量读取的结果项，out 的开头为 count 个结果项，其后为变长值的数据区
+struct BatchResultEntry {
+    uint32_t present;
+    uint32_t size;  // 变长值的字节长度
+    uint64_t value; // 定长值的位表示，或变长值数据在 out 中的偏移
+};
+
+static bool readBatchValue(MMKV *mmkv, const uint32_t type, const string &key, uint64_t &value) {
+    bool hasValue = false;
+    switch (type) {
+        case TypeBoolean:
+            value = mmkv->getBool(key, false, &hasValue);
+            break;
+        case TypeInt:
+            value = toBits(mmkv->getInt32(key, 0, &hasValue));
+            break;
+        case TypeUInt:
+            value = mmkv->getUInt32(key, 0, &hasValue);
+            break;
+        case TypeLong:
+            value = toBits(mmkv->getInt64(key, 0, &hasValue));
+            break;
+        case TypeULong:
+            value = mmkv->getUInt64(key, 0, &hasValue);
+            break;
+        case TypeFloat:
+            value = toBits(mmkv->getFloat(key, 0, &hasValue));
+            break;
+        case TypeDouble:
+            value = toBits(mmkv->getDouble(key, 0, &hasValue));
+            break;
+        default:
+            break;
+    }
+    return hasValue;
+}
+
+// 按 records（与 mmkv_setBatch 相同的格式，value 字段忽略）依次读取 count 个值写入 out，
+// 返回 out 所需的总字节数；大于 capacity 时数据区不完整，调用方需按返回值重新分配后再次调用。
+// 记录格式非法时返回 -1
+extern "C" int64_t mmkv_getBatch(MMKV *mmkv, const uint8_t *records, const size_t size, const size_t count,
+                                 uint8_t *out, const size_t capacity) {
+    writeBarrier(mmkv);
+    const size_t entriesSize = count * sizeof(BatchResultEntry);
+    if (records == nullptr || count == 0 || out == nullptr || capacity < entriesSize) {
+        return static_cast<int64_t>(entriesSize);
+    }
+    size_t required = entriesSize;
+    size_t offset = 0;
+    bool malformed = false;
+    const InstanceLock lock(mmkv, InstanceLock::Shared);
+    for (size_t i = 0; i < count; i++) {
+        if (offset + sizeof(BatchRecordHeader) > size) {
+            malformed = true;
+            break;
+        }
+        BatchRecordHeader header{};
+        memcpy(&header, records + offset, sizeof(header));
+        const size_t recordSize = alignTo8(sizeof(header) + header.keySize);
+        if (offset + recordSize > size) {
+            malformed = true;
+            break;
+        }
+        const string key(reinterpret_cast<const char *>(records + offset + sizeof(header)), header.keySize);
+        offset += recordSize;
+
+        BatchResultEntry entry{};
+        if (header.type == TypeString || header.type == TypeByteArray) {
+            if (MMBuffer buffer; mmkv->getBytes(key, buffer)) {
+                entry.present = 1;
+                entry.size = static_cast<uint32_t>(buffer.length());
+                entry.value = required;
+                if (required + buffer.length() <= capacity) {
+                    memcpy(out + required, buffer.getPtr(), buffer.length());
+                }
+                required += buffer.length();
+            }
+        } else {
+            entry.present = readBatchValue(mmkv, header.type, key, entry.value) ? 1 : 0;
+        }
+        memcpy(out + i * sizeof(BatchResultEntry), &entry, sizeof(entry));
     }
-    return mmkv->removeValueForKey(key);
+    return malformed ? -1 : static_cast<int64_t>(required);
 }
 
 extern "C" void mmkv_removeValueForKey(MMKV *mmkv, const char *key) {
-    mmkv->removeValueForKey(key);
+    removeValue(mmkv, key);
 }
 
 extern "C" void mmkv_removeValuesForKeys(MMKV *mmkv, const char **keys, const size_t size) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Maintenance);
     vector<string> vec;
     vec.reserve(size);
     for (size_t i = 0; i < size; ++i) {
         vec.emplace_back(keys[i]);
     }
-    mmkv->removeValuesForKeys(vec);
+    const InstanceLock lock(mmkv, InstanceLock::Write);
+    if (mmkv->removeValuesForKeys(vec)) {
+        notifyChanges(mmkv, vec);
+    }
+}
+
+extern "C" bool mmkv_removeValuesForKeysPacked(MMKV *mmkv, const uint8_t *packed, const size_t size) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Maintenance);
+    const InstanceLock lock(mmkv, InstanceLock::Write);
+    if (vector<string> vec; unpackStringList(packed, size, vec) && mmkv->removeValuesForKeys(vec)) {
+        notifyChanges(mmkv, vec);
+        return true;
+    }
+    return false;
 }
 
 extern "C" long mmkv_actualSize(MMKV *mmkv) {
+    writeBarrier(mmkv);
     return mmkv->actualSize();
 }
 
 extern "C" long mmkv_count(MMKV *mmkv) {
+    writeBarrier(mmkv);
     return mmkv->count();
 }
 
 extern "C" long mmkv_totalSize(MMKV *mmkv) {
+    writeBarrier(mmkv);
     return mmkv->totalSize();
 }
 
 extern "C" void mmkv_clearMemoryCache(MMKV *mmkv) {
+    writeBarrier(mmkv);
     mmkv->clearMemoryCache();
 }
 
 extern "C" void mmkv_clearAll(MMKV *mmkv) {
+    writeBarrier(mmkv);
+    const InstanceLock lock(mmkv, InstanceLock::Write);
     mmkv->clearAll();
+    notifyChange(mmkv, nullptr);
+}
+
+// AutoCompaction：按策略在后台线程上整理实例（全量回写并收缩文件），写入方不再因整理而阻塞。
+// 空闲以 actualSize 不再变化来判断，无需在写入路径上记录时间
+struct CompactionState {
+    double wasteRatio;
+    chrono::milliseconds idleTime;
+    size_t maxFileSize;
+    size_t lastActualSize;
+    chrono::steady_clock::time_point lastChange;
+    // 上次整理后的 actualSize，未再写入时不重复整理
+    size_t compactedActualSize;
+};
+
+static mutex g_compactionMutex;
+static condition_variable g_compactionCondition;
+static unordered_map<MMKV *, CompactionState> g_compactions;
+// 正在整理的实例，关闭自动整理时需等它整理完
+static const MMKV *g_compacting = nullptr;
+static bool g_compactionThreadStarted = false;
+
+static void trimInstance(MMKV *mmkv) {
+    writeBarrier(mmkv);
+    const StatsScope stats(mmkv, StatsScope::Maintenance);
+    if (const auto instance = instanceStats(mmkv)) {
+        instance->trims.fetch_add(1, memory_order_relaxed);
+    }
+    mmkv->trim();
+}
+
+// 空闲时间的一半作为检查间隔，限制在 [10ms, 1s]
+static chrono::milliseconds compactionCheckInterval() {
+    auto interval = chrono::milliseconds(1000);
+    for (const auto &[_, state]: g_compactions) {
+        interval = min(interval, max(state.idleTime / 2, chrono::milliseconds(10)));
+    }
+    return interval;
+}
+
+static bool needsCompaction(MMKV *mmkv, CompactionState &state, const chrono::steady_clock::time_point now) {
+    // 已按内存预算释放的实例不为检查而重新加载
+    if (!isResident(mmkv)) {
+        return false;
+    }
+    const size_t actualSize = mmkv->actualSize();
+    const size_t totalSize = mmkv->totalSize();
+    if (actualSize != state.lastActualSize) {
+        state.lastActualSize = actualSize;
+        state.lastChange = now;
+    }
+    if (actualSize == state.compactedActualSize || totalSize == 0) {
+        return false;
+    }
+    // 超过文件上限时不等空闲
+    if (state.maxFileSize > 0 && totalSize > state.maxFileSize) {
+        return true;
+    }
+    const double waste = 1.0 - static_cast<double>(actualSize) / static_cast<double>(totalSize);
+    return waste >= state.wasteRatio && now - state.lastChange >= state.idleTime;
+}
+
+static void runCompaction() {
+    unique_lock lock(g_compactionMutex);
+    while (true) {
+        if (g_compactions.empty()) {
+            g_compactionCondition.wait(lock);
+            continue;
+        }
+        g_compactionCondition.wait_for(lock, compactionCheckInterval());
+        const auto now = chrono::steady_clock::now();
+        vector<MMKV *> candidates;
+        for (auto &[mmkv, state]: g_compactions) {
+            if (needsCompaction(mmkv, state, now)) {
+                candidates.push_back(mmkv);
+            }
+        }
+        for (const auto mmkv: candidates) {
+            // 等待期间可能已被关闭
+            if (g_compactions.find(mmkv) == g_compactions.end()) {
+                continue;
+            }
+            g_compacting = mmkv;
+            lock.unlock();
+            trimInstance(mmkv);
+            const size_t actualSize = mmkv->actualSize();
+            lock.lock();
+            g_compacting = nullptr;
+            if (const auto it = g_compactions.find(mmkv); it != g_compactions.end()) {
+                it->second.compactedActualSize = actualSize;
+                it->second.lastActualSize = actualSize;
+            }
+            g_compactionCondition.notify_all();
+        }
+    }
+}
+
+// 开启时按策略自动整理：actualSize 占 totalSize 的比例不高于 1 - wasteRatio 且 idleMillis 毫秒内没有写入，
+// 或 totalSize 超过 maxFileSize（为 0 时不限制）。关闭时等待进行中的整理结束
+extern "C" void mmkv_enableAutoCompaction(MMKV *mmkv, const bool enable, const double wasteRatio,
+                                          const int64_t idleMillis, const uint64_t maxFileSize) {
+    unique_lock lock(g_compactionMutex);
+    if (enable) {
+        const size_t actualSize = mmkv->actualSize();
+        g_compactions[mmkv] = CompactionState{
+            wasteRatio, chrono::milliseconds(max<int64_t>(idleMillis, 0)), static_cast<size_t>(maxFileSize),
+            actualSize, chrono::steady_clock::now(), SIZE_MAX,
+        };
+        if (!g_compactionThreadStarted) {
+            g_compactionThreadStarted = true;
+            thread(runCompaction).detach();
+        }
+        g_compactionCondition.notify_all();
+        return;
+    }
+    g_compactions.erase(mmkv);
+    g_compactionCondition.wait(lock, [mmkv] { return g_compacting != mmkv; });
 }
 
 extern "C" void mmkv_close(MMKV *mmkv) {
+    awaitReKey(mmkv);
+    untrackInstance(mmkv);
+    mmkv_enableAutoCompaction(mmkv, false, 0, 0, 0);
+    mmkv_enableMergedCounters(mmkv, false, 0);
+    mmkv_enableWriteBehind(mmkv, false);
+    mmkv_enableStats(mmkv, false);
+    unwatchAll(mmkv);
+    mmkv_enableChangeNotify(mmkv, false);
+    {
+        lock_guard lock(g_journalsMutex);
+        g_journals.erase(mmkv);
+    }
     mmkv->close();
 }
 
 extern "C" StringListReturn *mmkv_allKeys(MMKV *mmkv) {
+    writeBarrier(mmkv);
     const vector<string> vector = mmkv->allKeys();
 
     const auto rtn = static_cast<StringListReturn *>(malloc(sizeof(StringListReturn)));
@@ -272,25 +2687,166 @@ extern "C" StringListReturn *mmkv_allKeys(MMKV *mmkv) {
     return rtn;
 }
 
+// 以紧凑格式返回所有 key
+extern "C" uint8_t *mmkv_allKeysPacked(MMKV *mmkv, size_t *size) {
+    writeBarrier(mmkv);
+    return packStringList(mmkv->allKeys(), size);
+}
+
+// 分批遍历 key 的游标，打开时按前缀过滤出快照，之后每次只交出一批。
+// MMKV 只能一次列出全部 key，快照的大小与匹配的 key 数成正比，交出的 key 随即释放
+struct KeyIterator {
+    vector<string> keys;
+    size_t position = 0;
+};
+
+extern "C" KeyIterator *mmkv_iterOpen(MMKV *mmkv, const char *prefix, const size_t prefixSize) {
+    writeBarrier(mmkv);
+    const auto iter = new KeyIterator();
+    iter->keys = mmkv->allKeys();
+    // 在 allKeys 的结果上原地过滤，不再另建一份
+    if (prefixSize > 0) {
+        auto &keys = iter->keys;
+        keys.erase(std::remove_if(keys.begin(), keys.end(), [&](const string &key) {
+            return key.compare(0, prefixSize, prefix, prefixSize) != 0;
+        }), keys.end());
+        keys.shrink_to_fit();
+    }
+    return iter;
+}
+
+// 以紧凑格式返回至多 batchSize 个 key，遍历结束时返回 nullptr；
+// withValueSizes 为 true 时在数据区之后（8 字节对齐）追加 int64 数组，为各 key 当前的值大小，已被删除的为 -1
+extern "C" uint8_t *mmkv_iterNext(MMKV *mmkv, KeyIterator *iter, const size_t batchSize, const bool withValueSizes, size_t *size) {
+    writeBarrier(mmkv);
+    if (iter->position >= iter->keys.size() || batchSize == 0) {
+        return nullptr;
+    }
+    const auto end = std::min(iter->keys.size(), iter->position + batchSize);
+    const vector<string> batch(std::make_move_iterator(iter->keys.begin() + static_cast<ptrdiff_t>(iter->position)),
+                               std::make_move_iterator(iter->keys.begin() + static_cast<ptrdiff_t>(end)));
+    iter->position = end;
+    if (!withValueSizes) {
+        return packStringList(batch, size);
+    }
+    const auto packed = packStringList(batch, size, sizeof(int64_t) * batch.size());
+    if (packed == nullptr) {
+        return nullptr;
+    }
+    const auto sizes = reinterpret_cast<int64_t *>(packed + *size - sizeof(int64_t) * batch.size());
+    for (size_t i = 0; i < batch.size(); i++) {
+        sizes[i] = valueSize(mmkv, batch[i]);
+    }
+    return packed;
+}
+
+extern "C" void mmkv_iterClose(const KeyIterator *iter) {
+    delete iter;
+}
+
 extern "C" bool mmkv_containsKey(MMKV *mmkv, const char *key) {
+    writeBarrier(mmkv);
     return mmkv->containsKey(key);
 }
 
 extern "C" void mmkv_checkReSetCryptKey(MMKV *mmkv, const char *cryptKey) {
+    writeBarrier(mmkv);
     const string crypt(cryptKey);
     mmkv->checkReSetCryptKey(&crypt);
 }
 
+static void runReKey(MMKV *mmkv, const string &cryptKey, const MMKVPath_t &root, const bool customRoot,
+                     ReKeyCallback *callback) {
+    const auto report = [mmkv, callback](const ReKeyStage stage) {
+        if (callback != nullptr) {
+            callback(mmkv, stage);
+        }
+    };
+    const auto &mmapID = mmkv->mmapID();
+    const auto backupDir = reKeyBackupDir(root, mmapID);
+    const auto srcDir = customRoot ? &root : nullptr;
+    // 清掉上次残留的标记，否则中途退出时会按残留的标记处理
+    removeReKeyBackup(backupDir);
+    error_code ec;
+    filesystem::create_directories(backupDir, ec);
+    // 已入队的写入与合并计数先落盘，它们在闸门关闭后会阻塞在闸门上
+    writeBarrier(mmkv);
+    bool backedUp = false;
+    bool succeeded = false;
+    {
+        // 从备份到 REWRITTEN 落盘之间不允许其他修改，否则恢复备份时会丢失它们
+        const auto gate = closeReKeyGate(mmkv);
+        {
+            const InstanceLock lock(mmkv, InstanceLock::Exclusive);
+            backedUp = !ec && MMKV::backupOneToDirectory(mmapID, backupDir, srcDir) &&
+                       markReKey(backupDir, REKEY_BACKED_UP);
+            if (backedUp) {
+                const StatsScope stats(mmkv, StatsScope::Maintenance);
+                succeeded = mmkv->reKey(cryptKey);
+                if (succeeded) {
+                    mmkv->sync(MMKV_SYNC);
+                    // 标记写入失败也不影响结果：下面删除备份时先删 BACKED_UP，打开时同样不会回滚
+                    markReKey(backupDir, REKEY_REWRITTEN);
+                } else {
+                    // 密钥未变，从备份恢复是安全的
+                    MMKV::restoreOneFromDirectory(mmapID, backupDir, srcDir);
+                }
+            }
+        }
+        openReKeyGate(mmkv, gate);
+    }
+    // 回调可能访问本实例，在闸门打开之后再依次报告
+    if (backedUp) {
+        report(ReKeyBackedUp);
+    }
+    if (succeeded) {
+        report(ReKeyRewritten);
+    }
+    removeReKeyBackup(backupDir);
+    {
+        lock_guard lock(g_reKeyMutex);
+        g_reKeyJobs.erase(mmkv);
+    }
+    g_reKeyFinished.notify_all();
+    report(succeeded ? ReKeyFinished : ReKeyFailed);
+}
+
+// 异步换密钥，cryptKey 为空时去除加密；rootPath 需与打开实例时一致。
+// 按阶段回调 callback（在后台线程上），最后一次为 ReKeyFinished 或 ReKeyFailed。
+// 从备份到新密钥落盘期间，本进程经绑定层的修改会等待；读取只在 MMKV 重写文件时等待实例锁，其余时间照常进行。
+// 各阶段在这段时间结束后才回调，调用线程不会被阻塞。
+// 仅支持单进程实例，多进程实例或已有换密钥在进行时返回 false
+extern "C" bool mmkv_reKeyAsync(MMKV *mmkv, const char *cryptKey, const size_t keySize, const char *rootPath,
+                                ReKeyCallback *callback) {
+    if (mmkv->isMultiProcess()) {
+        return false;
+    }
+    {
+        lock_guard lock(g_reKeyMutex);
+        if (!g_reKeyJobs.emplace(mmkv, mmkv->mmapID()).second) {
+            return false;
+        }
+    }
+    const bool customRoot = isNotNullOrEmpty(rootPath);
+    const MMKVPath_t root = customRoot ? MMKVPath_t(rootPath) : MMKV::getRootDir();
+    string key(cryptKey != nullptr ? cryptKey : "", cryptKey != nullptr ? keySize : 0);
+    thread([mmkv, key = std::move(key), root, customRoot, callback] {
+        runReKey(mmkv, key, root, customRoot, callback);
+    }).detach();
+    return true;
+}
+
 extern "C" char *mmkv_mmapID(const MMKV *mmkv) {
     return stringToChar(mmkv->mmapID());
 }
 
 extern "C" void mmkv_sync(MMKV *mmkv, bool flag) {
+    writeBarrier(mmkv);
     mmkv->sync(static_cast<SyncFlag>(flag));
 }
 
 extern "C" void mmkv_trim(MMKV *mmkv) {
-    mmkv->trim();
+    trimInstance(mmkv);
 }
 
 extern "C" bool mmkv_backupOneToDirectory(const char *mmapID, const char *dstDir, const char *srcDir) {
@@ -301,11 +2857,34 @@ extern "C" bool mmkv_backupOneToDirectory(const char *mmapID, const char *dstDir
     return MMKV::backupOneToDirectory(mmapID, dstDir, &srcPath);
 }
 
+// 将 src 的全部 key 导入 dst，同名 key 被覆盖，返回导入的个数。用于分片实例离线重新分布
+extern "C" size_t mmkv_importFrom(MMKV *dst, MMKV *src) {
+    writeBarrier(src);
+    writeBarrier(dst);
+    const StatsScope stats(dst, StatsScope::Maintenance);
+    const InstanceLock lock(dst, InstanceLock::Write);
+    const auto count = dst->importFrom(src);
+    if (count > 0) {
+        notifyChange(dst, nullptr);
+    }
+    return count;
+}
+
+// 删除实例的文件，实例需已关闭
+extern "C" bool mmkv_removeStorage(const char *mmapID, const char *rootPath) {
+    if (rootPath != nullptr) {
+        const MMKVPath_t root(rootPath);
+        return MMKV::removeStorage(mmapID, &root);
+    }
+    return MMKV::removeStorage(mmapID);
+}
+
 extern "C" long mmkv_pageSize() {
     return DEFAULT_MMAP_SIZE;
 }
 
 extern "C" void mmkv_setLogLevel(int level) {
+    g_logLevel.store(level, memory_order_relaxed);
     MMKV::setLogLevel(static_cast<MMKVLogLevel>(level));
 }
 
@@ -315,5 +2894,6 @@ extern "C" const char *mmkv_version() {
 
 extern "C" void mmkv_unregisterHandler() {
     g_logger = nullptr;
+    g_logBatchHandler = nullptr;
     MMKV::unRegisterHandler();
 }
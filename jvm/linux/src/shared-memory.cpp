@@ -0,0 +1,56 @@
+#include "shared-memory.h"
+
+#include <cerrno>
+#include <chrono>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr auto READY_TIMEOUT = std::chrono::seconds(1);
+
+} // namespace
+
+void *mapSharedMemory(const std::string &name, const size_t size, bool &created) {
+    created = true;
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        created = false;
+        fd = shm_open(name.c_str(), O_RDWR, 0600);
+    }
+    if (fd < 0) {
+        return nullptr;
+    }
+    if (created && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        close(fd);
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+    // 其他进程刚创建、尚未 ftruncate 时映射会越界，先等文件长度就绪
+    const auto deadline = std::chrono::steady_clock::now() + READY_TIMEOUT;
+    struct stat st {};
+    while (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) < size) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            close(fd);
+            return nullptr;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return ptr != MAP_FAILED ? ptr : nullptr;
+}
+
+bool awaitSharedMemoryReady(const std::atomic<uint32_t> &magic, const uint32_t expected) {
+    const auto deadline = std::chrono::steady_clock::now() + READY_TIMEOUT;
+    while (magic.load(std::memory_order_acquire) != expected) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
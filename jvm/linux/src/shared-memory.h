@@ -0,0 +1,16 @@
+#ifndef MMKV_SHARED_MEMORY_H
+#define MMKV_SHARED_MEMORY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 打开或创建 name 对应的共享内存（shm_open 的名字，以 '/' 开头）并映射 size 字节，失败时返回 nullptr。
+// 新创建的内容为全零，此时 created 为 true，由调用方初始化后发布 magic
+void *mapSharedMemory(const std::string &name, size_t size, bool &created);
+
+// 等待创建者发布 magic，创建者在初始化完成前退出时超时返回 false
+bool awaitSharedMemoryReady(const std::atomic<uint32_t> &magic, uint32_t expected);
+
+#endif // MMKV_SHARED_MEMORY_H
@@ -50,6 +50,9 @@ kotlin {
         all {
             languageSettings.optIn("kotlin.RequiresOptIn")
         }
+        commonMain.dependencies {
+            api(libs.kotlinx.coroutines.core)
+        }
         commonTest.dependencies {
             implementation(kotlin("test"))
         }
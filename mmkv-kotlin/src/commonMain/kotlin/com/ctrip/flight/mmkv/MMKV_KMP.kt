@@ -16,6 +16,9 @@
 
 package com.ctrip.flight.mmkv
 
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.asFlow
+
 /**
  * MMKV common source set expect class
  * @author yaqiao
@@ -47,6 +50,35 @@ interface MMKV_KMP {
 
     operator fun set(key: String, value: Set<String>?): Boolean
 
+    /**
+     * Write multiple values at once, a `null` value removes its key.
+     * Supported value types: String, Boolean, Int, Long, Float, Double, ByteArray, UInt, ULong
+     * @return `true` if all values were written
+     */
+    fun setAll(values: Map<String, Any?>): Boolean {
+        var succeeded = true
+        values.forEach { (key, value) ->
+            val result = when (value) {
+                null -> {
+                    removeValueForKey(key)
+                    true
+                }
+                is String -> set(key, value)
+                is Boolean -> set(key, value)
+                is Int -> set(key, value)
+                is Long -> set(key, value)
+                is Float -> set(key, value)
+                is Double -> set(key, value)
+                is ByteArray -> set(key, value)
+                is UInt -> set(key, value)
+                is ULong -> set(key, value)
+                else -> throw IllegalArgumentException("Unsupported value type ${value::class} for key $key")
+            }
+            succeeded = succeeded && result
+        }
+        return succeeded
+    }
+
     /**
      * Read value
      */
@@ -124,12 +156,44 @@ interface MMKV_KMP {
 
     fun getByteArray(key: String, default: ByteArray? = null): ByteArray?
 
+    /**
+     * Read a ByteArray value into [buffer] starting at [offset], so the buffer can be reused across reads.
+     * The value is copied only if it fits into the remaining space of [buffer]
+     * @return the size of the value, or -1 if the key does not exist
+     */
+    fun getByteArray(key: String, buffer: ByteArray, offset: Int): Int {
+        val value = getByteArray(key, null) ?: return -1
+        if (value.size <= buffer.size - offset) {
+            value.copyInto(buffer, offset)
+        }
+        return value.size
+    }
+
     fun getUInt(key: String, default: UInt = 0u): UInt
 
     fun getULong(key: String, default: ULong = 0u): ULong
 
     fun getStringSet(key: String, default: Set<String>? = null): Set<String>?
 
+    /**
+     * Read multiple values at once, the type of each value is decided by its default value.
+     * Supported default value types are the same as [setAll]
+     */
+    fun getAll(defaults: Map<String, Any>): Map<String, Any> = defaults.mapValues { (key, default) ->
+        when (default) {
+            is String -> getString(key, default)
+            is Boolean -> getBoolean(key, default)
+            is Int -> getInt(key, default)
+            is Long -> getLong(key, default)
+            is Float -> getFloat(key, default)
+            is Double -> getDouble(key, default)
+            is ByteArray -> getByteArray(key, default) ?: default
+            is UInt -> getUInt(key, default)
+            is ULong -> getULong(key, default)
+            else -> throw IllegalArgumentException("Unsupported value type ${default::class} for key $key")
+        }
+    }
+
     /**
      * Remove value
      */
@@ -164,6 +228,23 @@ interface MMKV_KMP {
 
     fun allKeys(): List<String>
 
+    /**
+     * Keys starting with [prefix], handed to Kotlin in batches of at most [batchSize] keys where the
+     * platform supports it, so large stores are not turned into one list of strings at once.
+     * The native side still snapshots every matching key when iteration starts, as MMKV can only list
+     * all keys at once, so native memory grows with the number of matching keys.
+     * Each iteration of the returned sequence starts over from a new snapshot of the keys
+     */
+    fun keys(prefix: String = "", batchSize: Int = 256): Sequence<String> {
+        require(batchSize > 0) { "batchSize must be positive, was $batchSize" }
+        return allKeys().asSequence().filter { it.startsWith(prefix) }
+    }
+
+    /**
+     * [keys] as a [Flow]
+     */
+    fun keysFlow(prefix: String = "", batchSize: Int = 256): Flow<String> = keys(prefix, batchSize).asFlow()
+
     fun containsKey(key: String): Boolean
 
     fun checkReSetCryptKey(key: String?)
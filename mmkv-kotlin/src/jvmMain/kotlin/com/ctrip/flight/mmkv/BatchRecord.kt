@@ -0,0 +1,77 @@
+package com.ctrip.flight.mmkv
+
+import java.lang.foreign.Arena
+import java.lang.foreign.MemorySegment
+import java.lang.foreign.ValueLayout.JAVA_BYTE
+import java.lang.foreign.ValueLayout.JAVA_INT
+import java.lang.foreign.ValueLayout.JAVA_LONG
+
+/**
+ * 批量写入记录，布局需与 native 侧 BatchRecordHeader 保持一致：
+ * type(u32) | keySize(u32) | value(u64) | key | data，整条记录按 8 字节对齐
+ */
+internal class BatchRecord(
+    val type: NativeValueType,
+    val key: ByteArray,
+    val value: Long,
+    val data: ByteArray? = null,
+) {
+    val byteSize: Long = alignTo8(HEADER_SIZE + key.size + (data?.size ?: 0))
+
+    fun writeTo(segment: MemorySegment, offset: Long) {
+        segment.set(JAVA_INT, offset, type.tag)
+        segment.set(JAVA_INT, offset + 4, key.size)
+        segment.set(JAVA_LONG, offset + 8, value)
+        MemorySegment.copy(key, 0, segment, JAVA_BYTE, offset + HEADER_SIZE, key.size)
+        if (data != null) {
+            MemorySegment.copy(data, 0, segment, JAVA_BYTE, offset + HEADER_SIZE + key.size, data.size)
+        }
+    }
+
+    companion object {
+        const val HEADER_SIZE = 16L
+
+        // native 侧 BatchResultEntry 的大小：present(u32) | size(u32) | value(u64)
+        const val RESULT_ENTRY_SIZE = 16L
+
+        /**
+         * 批量读取的请求记录，只携带 key 与期望的类型
+         */
+        fun query(key: String, default: Any): BatchRecord =
+            BatchRecord(NativeValueType.of(default), key.encodeToByteArray(), 0)
+
+        fun of(key: String, value: Any?): BatchRecord {
+            val cKey = key.encodeToByteArray()
+            return when (value) {
+                null -> BatchRecord(NativeValueType.REMOVE, cKey, 0)
+                is Boolean -> BatchRecord(NativeValueType.BOOLEAN, cKey, if (value) 1 else 0)
+                is Int -> BatchRecord(NativeValueType.INT, cKey, value.toLong())
+                is UInt -> BatchRecord(NativeValueType.UINT, cKey, value.toLong())
+                is Long -> BatchRecord(NativeValueType.LONG, cKey, value)
+                is ULong -> BatchRecord(NativeValueType.ULONG, cKey, value.toLong())
+                is Float -> BatchRecord(NativeValueType.FLOAT, cKey, value.toRawBits().toLong() and 0xFFFFFFFFL)
+                is Double -> BatchRecord(NativeValueType.DOUBLE, cKey, value.toRawBits())
+                is String -> value.encodeToByteArray().let {
+                    BatchRecord(NativeValueType.STRING, cKey, it.size.toLong(), it)
+                }
+                is ByteArray -> BatchRecord(NativeValueType.BYTE_ARRAY, cKey, value.size.toLong(), value)
+                else -> throw IllegalArgumentException("Unsupported value type ${value::class} for key $key")
+            }
+        }
+    }
+}
+
+internal fun alignTo8(size: Long): Long = (size + 7) and 7L.inv()
+
+/**
+ * 将所有记录连续写入一块 8 字节对齐的内存
+ */
+internal fun Arena.allocateBatch(records: List<BatchRecord>): MemorySegment {
+    val segment = allocate(records.sumOf { it.byteSize }, 8)
+    var offset = 0L
+    records.forEach {
+        it.writeTo(segment, offset)
+        offset += it.byteSize
+    }
+    return segment
+}
@@ -1,11 +1,13 @@
 package com.ctrip.flight.mmkv
 
+import java.util.concurrent.CompletableFuture
+
 actual fun defaultMMKV(): MMKV_KMP {
-    return NativeMMKV.defaultMMKV(MMKVMode.SINGLE_PROCESS.ordinal, null)
+    return NativeMMKV.defaultMMKV(MMKVMode.SINGLE_PROCESS.rawValue, null)
 }
 
 actual fun defaultMMKV(cryptKey: String): MMKV_KMP {
-    return NativeMMKV.defaultMMKV(MMKVMode.SINGLE_PROCESS.ordinal, cryptKey)
+    return NativeMMKV.defaultMMKV(MMKVMode.SINGLE_PROCESS.rawValue, cryptKey)
 }
 
 actual fun mmkvWithID(
@@ -14,5 +16,67 @@ actual fun mmkvWithID(
     cryptKey: String?,
     rootPath: String?
 ): MMKV_KMP {
-    return NativeMMKV.mmkvWithID(mmapId, mode.ordinal, cryptKey, rootPath)
-}
\ No newline at end of file
+    return NativeMMKV.mmkvWithID(mmapId, mode.rawValue, cryptKey, rootPath)
+}
+
+/**
+ * Open [ids] concurrently on a native worker pool, so that opening many instances at startup
+ * scales with the number of cores rather than with the number of instances.
+ * Each future completes as soon as its own instance is open.
+ * @param threads number of native worker threads, 0 for the number of CPU cores
+ */
+fun preload(
+    ids: List<String>,
+    mode: MMKVMode = MMKVMode.SINGLE_PROCESS,
+    threads: Int = 0,
+): List<CompletableFuture<MMKV_KMP>> {
+    val preload = NativeMMKV.preload
+        ?: return ids.map { id -> CompletableFuture.supplyAsync { mmkvWithID(id, mode) } }
+    val futures = ids.map { CompletableFuture<MMKV_KMP>() }
+    // native 调用阻塞到全部打开为止，放在单独的线程上
+    Thread.ofPlatform().daemon().name("mmkv-preload").start {
+        try {
+            preload(ids, List(ids.size) { mode.rawValue }, threads) { index, ptr ->
+                if (ptr.address() == 0L) {
+                    futures[index].completeExceptionally(IllegalStateException("failed to open ${ids[index]}"))
+                } else {
+                    futures[index].complete(MMKVImpl(ptr, mode == MMKVMode.MULTI_PROCESS))
+                }
+            }
+        } catch (e: Throwable) {
+            futures.forEach { it.completeExceptionally(e) }
+        }
+    }
+    return futures
+}
+
+/**
+ * Open the store [mmapId] spread over [shardCount] instances, see [MMKVSharded].
+ * A store keeps the shard count it was first opened with; opening it with another count fails
+ * with IllegalStateException until it is changed by [reshardMMKV]
+ */
+fun shardedMMKV(
+    mmapId: String,
+    shardCount: Int,
+    mode: MMKVMode = MMKVMode.SINGLE_PROCESS,
+    cryptKey: String? = null,
+    rootPath: String? = null,
+): MMKVSharded {
+    return MMKVSharded.open(mmapId, shardCount, mode, cryptKey, rootPath)
+}
+
+/**
+ * Move the keys of the sharded store [mmapId] to [shardCount] shards. This is an offline operation:
+ * the store must not be open in any process while it runs. The new layout is built next to the old
+ * shards first, so a process killed in the middle either keeps the old layout or finishes switching
+ * to the new one the next time the store is opened
+ */
+fun reshardMMKV(
+    mmapId: String,
+    shardCount: Int,
+    mode: MMKVMode = MMKVMode.SINGLE_PROCESS,
+    cryptKey: String? = null,
+    rootPath: String? = null,
+) {
+    MMKVSharded.reshard(mmapId, shardCount, mode, cryptKey, rootPath)
+}
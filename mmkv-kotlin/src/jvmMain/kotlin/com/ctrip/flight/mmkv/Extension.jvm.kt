@@ -0,0 +1,86 @@
+package com.ctrip.flight.mmkv
+
+import java.lang.foreign.MemorySegment
+
+/**
+ * MMKV JVM extension
+ */
+
+/**
+ * Read a ByteArray value into [segment] without intermediate copies when [segment] is off-heap,
+ * the value is copied only if it fits into [segment]
+ * @return the size of the value, or -1 if the key does not exist or does not hold a ByteArray or String
+ */
+fun MMKVImpl.getByteArray(key: String, segment: MemorySegment): Long {
+    if (segment.isNative) {
+        return readValueInto(key, segment)
+    }
+    val capacity = segment.byteSize()
+    val scratch = NativeScratch.get(capacity).asSlice(0, capacity)
+    val size = readValueInto(key, scratch)
+    if (size in 0..capacity) {
+        MemorySegment.copy(scratch, 0, segment, 0, size)
+    }
+    return size
+}
+
+operator fun MMKVImpl.set(key: MMKVKey, value: Int): Boolean =
+    key.withHandle { NativeMMKV.setIntByHandle(ptr, it, value) } ?: set(key.name, value)
+
+operator fun MMKVImpl.set(key: MMKVKey, value: UInt): Boolean =
+    key.withHandle { NativeMMKV.setUIntByHandle(ptr, it, value) } ?: set(key.name, value)
+
+operator fun MMKVImpl.set(key: MMKVKey, value: Long): Boolean =
+    key.withHandle { NativeMMKV.setLongByHandle(ptr, it, value) } ?: set(key.name, value)
+
+operator fun MMKVImpl.set(key: MMKVKey, value: ULong): Boolean =
+    key.withHandle { NativeMMKV.setULongByHandle(ptr, it, value) } ?: set(key.name, value)
+
+operator fun MMKVImpl.set(key: MMKVKey, value: Float): Boolean =
+    key.withHandle { NativeMMKV.setFloatByHandle(ptr, it, value) } ?: set(key.name, value)
+
+operator fun MMKVImpl.set(key: MMKVKey, value: Double): Boolean =
+    key.withHandle { NativeMMKV.setDoubleByHandle(ptr, it, value) } ?: set(key.name, value)
+
+operator fun MMKVImpl.set(key: MMKVKey, value: Boolean): Boolean =
+    key.withHandle { NativeMMKV.setBooleanByHandle(ptr, it, value) } ?: set(key.name, value)
+
+operator fun MMKVImpl.set(key: MMKVKey, value: String): Boolean =
+    key.withHandle { NativeMMKV.setStringByHandle(ptr, it, value) } ?: set(key.name, value)
+
+operator fun MMKVImpl.set(key: MMKVKey, value: ByteArray): Boolean =
+    key.withHandle { NativeMMKV.setByteArrayByHandle(ptr, it, value) } ?: set(key.name, value)
+
+fun MMKVImpl.getInt(key: MMKVKey, default: Int = 0): Int =
+    key.withHandle { NativeMMKV.getIntByHandle(ptr, it, default) } ?: getInt(key.name, default)
+
+fun MMKVImpl.getUInt(key: MMKVKey, default: UInt = 0u): UInt =
+    key.withHandle { NativeMMKV.getUIntByHandle(ptr, it, default) } ?: getUInt(key.name, default)
+
+fun MMKVImpl.getLong(key: MMKVKey, default: Long = 0): Long =
+    key.withHandle { NativeMMKV.getLongByHandle(ptr, it, default) } ?: getLong(key.name, default)
+
+fun MMKVImpl.getULong(key: MMKVKey, default: ULong = 0u): ULong =
+    key.withHandle { NativeMMKV.getULongByHandle(ptr, it, default) } ?: getULong(key.name, default)
+
+fun MMKVImpl.getFloat(key: MMKVKey, default: Float = 0f): Float =
+    key.withHandle { NativeMMKV.getFloatByHandle(ptr, it, default) } ?: getFloat(key.name, default)
+
+fun MMKVImpl.getDouble(key: MMKVKey, default: Double = 0.0): Double =
+    key.withHandle { NativeMMKV.getDoubleByHandle(ptr, it, default) } ?: getDouble(key.name, default)
+
+fun MMKVImpl.getBoolean(key: MMKVKey, default: Boolean = false): Boolean =
+    key.withHandle { NativeMMKV.getBooleanByHandle(ptr, it, default) } ?: getBoolean(key.name, default)
+
+fun MMKVImpl.getString(key: MMKVKey, default: String = ""): String =
+    key.withHandle { NativeMMKV.getStringByHandle(ptr, it, default) } ?: getString(key.name, default)
+
+fun MMKVImpl.getByteArray(key: MMKVKey, default: ByteArray? = null): ByteArray? =
+    if (key.handle != null) key.withHandle { NativeMMKV.getByteArrayByHandle(ptr, it, default) } else getByteArray(key.name, default)
+
+fun MMKVImpl.removeValueForKey(key: MMKVKey) {
+    if (key.handle != null) key.withHandle { NativeMMKV.removeValueByHandle(ptr, it) } else removeValueForKey(key.name)
+}
+
+fun MMKVImpl.containsKey(key: MMKVKey): Boolean =
+    key.withHandle { NativeMMKV.containsKeyByHandle(ptr, it) } ?: containsKey(key.name)
@@ -10,25 +10,44 @@ import java.nio.file.Files
 import java.nio.file.StandardCopyOption
 import java.util.UUID
 
-fun initialize(rootDir: String, logLevel: MMKVLogLevel = MMKVLogLevel.LevelDebug) {
+/**
+ * @param asyncLog deliver native logs in batches on a background thread instead of the logging thread,
+ * only takes effect when the native library supports it
+ */
+fun initialize(
+    rootDir: String,
+    logLevel: MMKVLogLevel = MMKVLogLevel.LevelDebug,
+    asyncLog: Boolean = false,
+) {
     NativeMMKV.global = Arena.ofShared()
     NativeMMKV.dll = SymbolLookup.libraryLookup(defaultLoader.load(), NativeMMKV.global)
-    NativeMMKV.initialize(rootDir, logLevel.ordinal) { level, tag, message ->
-        if (level != MMKVLogLevel.LevelNone.ordinal) {
-            val logMessage = when (level) {
-                MMKVLogLevel.LevelDebug.ordinal -> "DEBUG: $message"
-                MMKVLogLevel.LevelInfo.ordinal -> "INFO: $message"
-                MMKVLogLevel.LevelWarning.ordinal -> "WARNING: $message"
-                MMKVLogLevel.LevelError.ordinal -> "ERROR: $message"
-                else -> message
+    val initializeWithLogHandler = NativeMMKV.initializeWithLogHandler
+    if (initializeWithLogHandler != null) {
+        // 级别过滤已在 native 侧完成
+        initializeWithLogHandler(rootDir, logLevel.ordinal, asyncLog) { level, file, line, function, message ->
+            if (level != MMKVLogLevel.LevelNone.ordinal) {
+                println("[$file:$line $function] ${formatLog(level, message)}")
+            }
+        }
+    } else {
+        NativeMMKV.initialize(rootDir, logLevel.ordinal) { level, tag, message ->
+            if (level != MMKVLogLevel.LevelNone.ordinal) {
+                if (level < logLevel.ordinal) return@initialize
+                println("[$tag] ${formatLog(level, message)}")
             }
-            if (level < logLevel.ordinal) return@initialize
-            println("[$tag] $logMessage")
         }
     }
     NativeMMKV.isInitialized = true
 }
 
+private fun formatLog(level: Int, message: String): String = when (level) {
+    MMKVLogLevel.LevelDebug.ordinal -> "DEBUG: $message"
+    MMKVLogLevel.LevelInfo.ordinal -> "INFO: $message"
+    MMKVLogLevel.LevelWarning.ordinal -> "WARNING: $message"
+    MMKVLogLevel.LevelError.ordinal -> "ERROR: $message"
+    else -> message
+}
+
 /**
  * MMKV C库加载器接口
  */
@@ -0,0 +1,49 @@
+package com.ctrip.flight.mmkv
+
+import java.lang.foreign.MemorySegment
+import java.lang.ref.Cleaner
+
+/**
+ * native 游标返回的一批 key，[valueSizes] 仅在请求时存在，与 [keys] 一一对应
+ */
+internal class KeyBatch(val keys: List<String>, val valueSizes: LongArray?)
+
+/**
+ * 按前缀分批遍历 key 的 native 游标，遍历结束或 [close] 时释放，
+ * 未遍历完就被丢弃的游标由 Cleaner 兜底释放。仅供单个使用方顺序读取
+ */
+internal class KeyCursor(private val mmkv: MemorySegment, prefix: String) : AutoCloseable {
+
+    private val iter: MemorySegment = NativeMMKV.iterOpen!!(mmkv, prefix)
+
+    private val cleanable = cleaner.register(this, IterReleaser(iter))
+
+    private var closed = false
+
+    fun next(batchSize: Int, withValueSizes: Boolean): KeyBatch? {
+        if (closed) {
+            return null
+        }
+        val batch = NativeMMKV.iterNext(mmkv, iter, batchSize, withValueSizes)
+        if (batch == null) {
+            close()
+        }
+        return batch
+    }
+
+    override fun close() {
+        closed = true
+        cleanable.clean()
+    }
+
+    // 不能持有 KeyCursor 本身，否则永远不会被回收
+    private class IterReleaser(private val iter: MemorySegment) : Runnable {
+        override fun run() {
+            NativeMMKV.iterClose(iter)
+        }
+    }
+
+    private companion object {
+        val cleaner: Cleaner = Cleaner.create()
+    }
+}
@@ -0,0 +1,19 @@
+package com.ctrip.flight.mmkv
+
+/**
+ * When [MMKVImpl.enableAutoCompaction] compacts an instance: once at least [wasteRatio] of [MMKV_KMP.totalSize]
+ * is not covered by [MMKV_KMP.actualSize] and nothing was written for [idleMillis], or as soon as
+ * [MMKV_KMP.totalSize] exceeds [maxFileSize] (0 for no limit). An instance is not compacted again
+ * until it has been written to since the last compaction
+ */
+data class MMKVCompactionPolicy(
+    val wasteRatio: Double = 0.5,
+    val idleMillis: Long = 1000,
+    val maxFileSize: Long = 0,
+) {
+    init {
+        require(wasteRatio in 0.0..1.0) { "wasteRatio must be in [0, 1]" }
+        require(idleMillis >= 0) { "idleMillis must not be negative" }
+        require(maxFileSize >= 0) { "maxFileSize must not be negative" }
+    }
+}
@@ -1,32 +1,41 @@
 package com.ctrip.flight.mmkv
 
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.channels.awaitClose
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.buffer
+import kotlinx.coroutines.flow.callbackFlow
+import kotlinx.coroutines.flow.flow
 import java.lang.foreign.MemorySegment
+import java.util.concurrent.CompletableFuture
 
 class MMKVImpl(
-    private val ptr: MemorySegment
+    internal val ptr: MemorySegment,
+    private val isMultiProcess: Boolean = false,
 ) : MMKV_KMP {
+
     override fun set(key: String, value: String): Boolean {
         return NativeMMKV.setString(ptr, key, value)
     }
 
     override fun set(key: String, value: Boolean): Boolean {
-        return NativeMMKV.setBoolean(ptr, key, value)
+        return NativePrimitives.setBoolean(ptr, key, value)
     }
 
     override fun set(key: String, value: Int): Boolean {
-        return NativeMMKV.setInt(ptr, key, value)
+        return NativePrimitives.setInt(ptr, key, value)
     }
 
     override fun set(key: String, value: Long): Boolean {
-        return NativeMMKV.setLong(ptr, key, value)
+        return NativePrimitives.setLong(ptr, key, value)
     }
 
     override fun set(key: String, value: Float): Boolean {
-        return NativeMMKV.setFloat(ptr, key, value)
+        return NativePrimitives.setFloat(ptr, key, value)
     }
 
     override fun set(key: String, value: Double): Boolean {
-        return NativeMMKV.setDouble(ptr, key, value)
+        return NativePrimitives.setDouble(ptr, key, value)
     }
 
     override fun set(key: String, value: ByteArray): Boolean {
@@ -34,11 +43,11 @@ class MMKVImpl(
     }
 
     override fun set(key: String, value: UInt): Boolean {
-        return NativeMMKV.setUInt(ptr, key, value)
+        return NativePrimitives.setUInt(ptr, key, value)
     }
 
     override fun set(key: String, value: ULong): Boolean {
-        return NativeMMKV.setULong(ptr, key, value)
+        return NativePrimitives.setULong(ptr, key, value)
     }
 
     override fun set(
@@ -48,6 +57,10 @@ class MMKVImpl(
         return NativeMMKV.setStringSet(ptr, key, value)
     }
 
+    override fun setAll(values: Map<String, Any?>): Boolean {
+        return NativeMMKV.setBatch?.invoke(ptr, values) ?: super.setAll(values)
+    }
+
     @Deprecated(
         message = "Renamed to 'getString' for clarity, as the 'take' prefix could be confusing.",
         replaceWith = ReplaceWith("getString(key, default)")
@@ -121,35 +134,43 @@ class MMKVImpl(
     }
 
     override fun getBoolean(key: String, default: Boolean): Boolean {
-        return NativeMMKV.getBoolean(ptr, key, default)
+        return NativePrimitives.getBoolean(ptr, key, default)
     }
 
     override fun getInt(key: String, default: Int): Int {
-        return NativeMMKV.getInt(ptr, key, default)
+        return NativePrimitives.getInt(ptr, key, default)
     }
 
     override fun getLong(key: String, default: Long): Long {
-        return NativeMMKV.getLong(ptr, key, default)
+        return NativePrimitives.getLong(ptr, key, default)
     }
 
     override fun getFloat(key: String, default: Float): Float {
-        return NativeMMKV.getFloat(ptr, key, default)
+        return NativePrimitives.getFloat(ptr, key, default)
     }
 
     override fun getDouble(key: String, default: Double): Double {
-        return NativeMMKV.getDouble(ptr, key, default)
+        return NativePrimitives.getDouble(ptr, key, default)
     }
 
     override fun getByteArray(key: String, default: ByteArray?): ByteArray? {
         return NativeMMKV.getByteArray(ptr, key, default)
     }
 
+    override fun getByteArray(key: String, buffer: ByteArray, offset: Int): Int {
+        // offset 越界时的行为与公共实现保持一致
+        if (NativeMMKV.readValueInto == null || offset < 0 || offset > buffer.size) {
+            return super.getByteArray(key, buffer, offset)
+        }
+        return getByteArray(key, MemorySegment.ofArray(buffer).asSlice(offset.toLong())).toInt()
+    }
+
     override fun getUInt(key: String, default: UInt): UInt {
-        return NativeMMKV.getUInt(ptr, key, default)
+        return NativePrimitives.getUInt(ptr, key, default)
     }
 
     override fun getULong(key: String, default: ULong): ULong {
-        return NativeMMKV.getULong(ptr, key, default)
+        return NativePrimitives.getULong(ptr, key, default)
     }
 
     override fun getStringSet(
@@ -159,6 +180,10 @@ class MMKVImpl(
         return NativeMMKV.getStringSet(ptr, key, default)
     }
 
+    override fun getAll(defaults: Map<String, Any>): Map<String, Any> {
+        return NativeMMKV.getBatch?.invoke(ptr, defaults) ?: super.getAll(defaults)
+    }
+
     override fun removeValueForKey(key: String) {
         NativeMMKV.removeValueForKey(ptr, key)
     }
@@ -190,6 +215,60 @@ class MMKVImpl(
         return NativeMMKV.allKeys(ptr)
     }
 
+    override fun keys(prefix: String, batchSize: Int): Sequence<String> {
+        require(batchSize > 0) { "batchSize must be positive, was $batchSize" }
+        if (NativeMMKV.iterOpen == null) {
+            return super.keys(prefix, batchSize)
+        }
+        return sequence {
+            KeyCursor(ptr, prefix).use { cursor ->
+                while (true) {
+                    val batch = cursor.next(batchSize, false) ?: break
+                    yieldAll(batch.keys)
+                }
+            }
+        }
+    }
+
+    override fun keysFlow(prefix: String, batchSize: Int): Flow<String> {
+        require(batchSize > 0) { "batchSize must be positive, was $batchSize" }
+        if (NativeMMKV.iterOpen == null) {
+            return super.keysFlow(prefix, batchSize)
+        }
+        // 收集被取消时也能及时释放 native 游标
+        return flow {
+            KeyCursor(ptr, prefix).use { cursor ->
+                while (true) {
+                    val batch = cursor.next(batchSize, false) ?: break
+                    batch.keys.forEach { emit(it) }
+                }
+            }
+        }
+    }
+
+    /**
+     * Like [keys], but also reports the current size of each value.
+     * A key removed after the iteration started has a size of -1
+     */
+    fun keyEntries(prefix: String = "", batchSize: Int = 256): Sequence<MMKVKeyEntry> {
+        require(batchSize > 0) { "batchSize must be positive, was $batchSize" }
+        if (NativeMMKV.iterOpen == null) {
+            val valueSize = NativeMMKV.valueSize
+            return super.keys(prefix, batchSize).map { MMKVKeyEntry(it, valueSize?.invoke(ptr, it) ?: -1) }
+        }
+        return sequence {
+            KeyCursor(ptr, prefix).use { cursor ->
+                while (true) {
+                    val batch = cursor.next(batchSize, true) ?: break
+                    val valueSizes = batch.valueSizes!!
+                    batch.keys.forEachIndexed { index, key ->
+                        yield(MMKVKeyEntry(key, valueSizes[index]))
+                    }
+                }
+            }
+        }
+    }
+
     override fun containsKey(key: String): Boolean {
         return NativeMMKV.containsKey(ptr, key)
     }
@@ -213,4 +292,224 @@ class MMKVImpl(
     override fun trim() {
         NativeMMKV.trim(ptr)
     }
-}
\ No newline at end of file
+
+    /**
+     * Stage the writes and removals made by [block] and apply them all at once. Other processes never
+     * see some of them without the others, and if this process dies while applying them, the rest are
+     * applied the next time the instance is opened or committed to, unless the instance has been written
+     * since; then the unfinished batch is dropped rather than overwriting newer values. Nothing is
+     * written if [block] throws.
+     * @return whether every staged change was written
+     */
+    fun transaction(block: MMKVTransaction.() -> Unit): Boolean {
+        val begin = NativeMMKV.txnBegin
+            ?: throw UnsupportedOperationException("mmkv_txnBegin is not available in this native library")
+        val transaction = MMKVTransaction(begin(ptr))
+        try {
+            transaction.block()
+        } catch (e: Throwable) {
+            transaction.abort()
+            throw e
+        }
+        return transaction.commit()
+    }
+
+    /**
+     * Add [delta] to the value of [key] and return the new value, starting from [default] if the key
+     * is absent. The read and the write happen in one native call under the instance lock, so concurrent
+     * additions from other threads and processes are not lost. Overflow wraps around
+     */
+    fun addAndGet(key: String, delta: Int, default: Int = 0): Int {
+        return NativePrimitives.addInt(ptr, key, delta, default)
+    }
+
+    /**
+     * Same as [addAndGet] for Long values
+     */
+    fun addAndGet(key: String, delta: Long, default: Long = 0L): Long {
+        return NativePrimitives.addLong(ptr, key, delta, default)
+    }
+
+    /**
+     * Add [delta] to the Long value of [key] without waiting for it to be written. While merged counters
+     * are enabled, see [enableMergedCounters], deltas are summed in memory and written periodically;
+     * otherwise this is the same as [addAndGet]
+     */
+    fun addMerged(key: String, delta: Long) {
+        NativePrimitives.addLongMerged(ptr, key, delta)
+    }
+
+    /**
+     * Turn merged counters on or off for this instance. While they are on, [addMerged] only sums the
+     * deltas in memory and a background native thread writes them every [flushMillis] milliseconds.
+     * Reads and other operations in this process write the pending deltas first; deltas not written
+     * yet are lost if the process dies. Turning them off writes the pending deltas
+     */
+    fun enableMergedCounters(enable: Boolean = true, flushMillis: Long = 1000) {
+        val setMergedCounters = NativeMMKV.enableMergedCounters
+            ?: throw UnsupportedOperationException("mmkv_enableMergedCounters is not available in this native library")
+        setMergedCounters(ptr, enable, flushMillis)
+    }
+
+    /**
+     * Set [key] to [value] only if its current value equals [expected], in one native call under the
+     * instance lock. Returns false if the key is absent
+     */
+    fun compareAndSet(key: String, expected: Int, value: Int): Boolean {
+        return NativePrimitives.compareAndSetInt(ptr, key, expected, value)
+    }
+
+    fun compareAndSet(key: String, expected: UInt, value: UInt): Boolean {
+        return NativePrimitives.compareAndSetUInt(ptr, key, expected, value)
+    }
+
+    fun compareAndSet(key: String, expected: Long, value: Long): Boolean {
+        return NativePrimitives.compareAndSetLong(ptr, key, expected, value)
+    }
+
+    fun compareAndSet(key: String, expected: ULong, value: ULong): Boolean {
+        return NativePrimitives.compareAndSetULong(ptr, key, expected, value)
+    }
+
+    /**
+     * Floating-point values are compared bit by bit, so NaN matches NaN and 0.0 does not match -0.0
+     */
+    fun compareAndSet(key: String, expected: Float, value: Float): Boolean {
+        return NativePrimitives.compareAndSetFloat(ptr, key, expected, value)
+    }
+
+    fun compareAndSet(key: String, expected: Double, value: Double): Boolean {
+        return NativePrimitives.compareAndSetDouble(ptr, key, expected, value)
+    }
+
+    fun compareAndSet(key: String, expected: Boolean, value: Boolean): Boolean {
+        return NativePrimitives.compareAndSetBoolean(ptr, key, expected, value)
+    }
+
+    /**
+     * Turn write-behind mode on or off for this instance. While it is on, writes return as soon as
+     * they are queued and a background native thread applies them in batches, keeping only the
+     * latest write of each key. Reads and other operations in this process still see queued writes.
+     * Turning it off applies all queued writes first
+     */
+    fun enableWriteBehind(enable: Boolean = true) {
+        val setWriteBehind = NativeMMKV.enableWriteBehind
+            ?: throw UnsupportedOperationException("mmkv_enableWriteBehind is not available in this native library")
+        setWriteBehind(ptr, enable)
+    }
+
+    /**
+     * Turn background compaction on or off for this instance. While it is on, a background native
+     * thread rewrites the live entries and shrinks the file whenever [policy] says so, instead of
+     * leaving the space to be reclaimed by an explicit [trim]. Turning it off waits for a running
+     * compaction to finish
+     */
+    fun enableAutoCompaction(enable: Boolean = true, policy: MMKVCompactionPolicy = MMKVCompactionPolicy()) {
+        val setAutoCompaction = NativeMMKV.enableAutoCompaction
+            ?: throw UnsupportedOperationException("mmkv_enableAutoCompaction is not available in this native library")
+        setAutoCompaction(ptr, enable, policy.wasteRatio, policy.idleMillis, policy.maxFileSize)
+    }
+
+    /**
+     * Wait until all writes queued before this call are applied.
+     * @return false if any queued write failed since the last flush, always true outside write-behind mode
+     */
+    fun flush(): Boolean {
+        return NativeMMKV.flush?.invoke(ptr) ?: true
+    }
+
+    /**
+     * Turn change notifications on or off for this instance. While they are on, every write from
+     * this process is published to a shared-memory feed that [changes] collectors, in this and in
+     * other processes, wait on. Writes from processes that have not turned them on are not seen.
+     * @return whether notifications are in use; false when shared memory is unavailable
+     */
+    fun enableChangeNotify(enable: Boolean = true): Boolean {
+        return NativeMMKV.enableChangeNotify?.invoke(ptr, enable) ?: false
+    }
+
+    /**
+     * Emit the keys starting with [keyPrefix] as they are changed, without polling. A null key means
+     * some change could not be identified, for example a [clearAll], a very long key, or changes that
+     * were overwritten in the feed before they were read; collectors should re-read everything they
+     * care about. Changes are delivered in write order and repeated changes of a key may be merged.
+     * Only writes made after collection started are emitted, see [enableChangeNotify]
+     */
+    fun changes(keyPrefix: String = ""): Flow<String?> {
+        val watch = NativeMMKV.watch
+            ?: throw UnsupportedOperationException("mmkv_watch is not available in this native library")
+        val unwatch = NativeMMKV.unwatch!!
+        // 回调在 native 线程上，不能挂起，缓冲不设上限
+        return callbackFlow {
+            val id = watch(ptr, keyPrefix) { trySend(it) }
+            check(id != 0L) { "failed to open the change feed" }
+            awaitClose { unwatch(id) }
+        }.buffer(Channel.UNLIMITED)
+    }
+
+    /**
+     * Change the encryption key on a background native thread instead of blocking the caller while
+     * the whole file is rewritten. The files are backed up first, so a process killed in the middle
+     * still opens the data with the old key next time. Writes to this instance wait from the backup
+     * until the new key is on disk; reads only wait while MMKV rewrites the file. Closing the
+     * instance waits for the re-key to finish.
+     * @param cryptKey the new key, null to turn encryption off
+     * @param rootPath the root directory the instance was opened with, null for the default one
+     * @param onProgress called on the native thread for each [MMKVReKeyStage], after writes are
+     * allowed again, so it may use this instance
+     * @return completes with whether the new key is in use; completes with false at once for
+     * multi-process instances or while another re-key of this instance is running
+     */
+    fun reKeyAsync(
+        cryptKey: String?,
+        rootPath: String? = null,
+        onProgress: ((MMKVReKeyStage) -> Unit)? = null,
+    ): CompletableFuture<Boolean> {
+        val reKey = NativeMMKV.reKeyAsync
+            ?: throw UnsupportedOperationException("mmkv_reKeyAsync is not available in this native library")
+        val result = CompletableFuture<Boolean>()
+        val started = reKey(ptr, cryptKey, rootPath) { ordinal ->
+            val stage = MMKVReKeyStage.entries[ordinal]
+            onProgress?.invoke(stage)
+            when (stage) {
+                MMKVReKeyStage.FINISHED -> result.complete(true)
+                MMKVReKeyStage.FAILED -> result.complete(false)
+                else -> Unit
+            }
+        }
+        if (!started) {
+            result.complete(false)
+        }
+        return result
+    }
+
+    /**
+     * Turn per-instance counters and get/set latency histograms on or off, see [MMKVStats].
+     * Turning them on starts counting from zero, turning them off discards the counters
+     */
+    fun enableStats(enable: Boolean = true) {
+        val setStats = NativeMMKV.enableStats
+            ?: throw UnsupportedOperationException("mmkv_enableStats is not available in this native library")
+        setStats(ptr, enable)
+    }
+
+    /**
+     * @return the counters since stats were enabled, or null if they are not enabled
+     */
+    fun stats(): MMKVStats? {
+        if (NativeMMKV.enableStats == null) {
+            return null
+        }
+        return NativeMMKV.stats(ptr)
+    }
+
+    /**
+     * 将值写入 native 内存 [dst]，仅在容量足够时写入
+     * @return 值的大小，key 不存在时返回 -1
+     */
+    internal fun readValueInto(key: String, dst: MemorySegment): Long {
+        val readInto = NativeMMKV.readValueInto
+            ?: throw UnsupportedOperationException("mmkv_readValueInto is not available in this native library")
+        return readInto(ptr, key, dst)
+    }
+}
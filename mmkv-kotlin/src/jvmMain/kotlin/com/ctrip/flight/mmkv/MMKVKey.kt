@@ -0,0 +1,53 @@
+package com.ctrip.flight.mmkv
+
+import java.lang.foreign.MemorySegment
+import java.lang.ref.Cleaner
+import java.lang.ref.Reference
+
+/**
+ * A pre-registered key for hot-path reads and writes, it caches the native key
+ * so repeated accesses skip UTF-8 encoding and native string construction.
+ * The native key is released when this object becomes unreachable.
+ * Falls back to plain String keys when the native library doesn't support key handles.
+ * Must be created after [initialize]
+ */
+class MMKVKey(val name: String) {
+
+    internal val handle: MemorySegment? = NativeMMKV.keyHandle?.invoke(name)
+
+    init {
+        if (handle != null) {
+            cleaner.register(this, KeyHandleReleaser(handle))
+        }
+    }
+
+    /**
+     * 以 native key 调用 [block]，未使用 native key 时返回 null。
+     * [block] 返回前保持自身可达，Cleaner 不会在 downcall 进行中释放 native key
+     */
+    internal inline fun <T> withHandle(block: (MemorySegment) -> T): T? {
+        val handle = handle ?: return null
+        try {
+            return block(handle)
+        } finally {
+            Reference.reachabilityFence(this)
+        }
+    }
+
+    override fun equals(other: Any?): Boolean = other is MMKVKey && other.name == name
+
+    override fun hashCode(): Int = name.hashCode()
+
+    override fun toString(): String = "MMKVKey($name)"
+
+    // 不能持有 MMKVKey 本身，否则永远不会被回收
+    private class KeyHandleReleaser(private val handle: MemorySegment) : Runnable {
+        override fun run() {
+            NativeMMKV.releaseKeyHandle(handle)
+        }
+    }
+
+    private companion object {
+        val cleaner: Cleaner = Cleaner.create()
+    }
+}
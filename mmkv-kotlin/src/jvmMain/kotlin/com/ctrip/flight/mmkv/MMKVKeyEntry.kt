@@ -0,0 +1,7 @@
+package com.ctrip.flight.mmkv
+
+/**
+ * A key together with the size in bytes of its stored value, -1 if the key no longer exists.
+ * MMKV doesn't record value types, so the size is all that can be reported
+ */
+data class MMKVKeyEntry(val key: String, val valueSize: Long)
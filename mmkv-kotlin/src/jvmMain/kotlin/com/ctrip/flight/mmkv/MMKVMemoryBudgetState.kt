@@ -0,0 +1,14 @@
+package com.ctrip.flight.mmkv
+
+/**
+ * State of the memory budget set by [setMemoryBudget]. [residentBytes] is the estimate from the
+ * last check, counting the mapped file plus the decoded values of each loaded instance; it is an
+ * upper bound for instances that are not encrypted. [evictions] counts released instances since startup
+ */
+data class MMKVMemoryBudgetState(
+    val budgetBytes: Long,
+    val residentBytes: Long,
+    val instances: Long,
+    val residentInstances: Long,
+    val evictions: Long,
+)
@@ -0,0 +1,19 @@
+package com.ctrip.flight.mmkv
+
+/**
+ * Progress of [MMKVImpl.reKeyAsync], in the order the stages are reported.
+ * Exactly one of [FINISHED] and [FAILED] is reported last
+ */
+enum class MMKVReKeyStage {
+    /** The instance files were copied aside; a crash from here on restores them on the next open */
+    BACKED_UP,
+
+    /** The data was rewritten with the new key and synced to disk */
+    REWRITTEN,
+
+    /** The new key is in use and the backup was removed */
+    FINISHED,
+
+    /** The old key is still in use, the instance was restored from the backup if needed */
+    FAILED,
+}
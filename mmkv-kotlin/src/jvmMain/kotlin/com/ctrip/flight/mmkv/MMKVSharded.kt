@@ -0,0 +1,351 @@
+package com.ctrip.flight.mmkv
+
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.emitAll
+import kotlinx.coroutines.flow.flow
+import java.util.concurrent.CompletableFuture
+
+/**
+ * A store spread over [shardCount] instances named `<mmapId>.shard-<k>`, each key living in the shard
+ * picked by a stable hash of the key. Writers of keys in different shards don't wait on each other, and
+ * every full write-back or [trim] rewrites one shard file instead of the whole store.
+ * The shard count is recorded when the store is first opened and only changes through [reshardMMKV]
+ */
+class MMKVSharded internal constructor(
+    private val mmapId: String,
+    private val shards: List<MMKVImpl>,
+) : MMKV_KMP {
+
+    val shardCount: Int
+        get() = shards.size
+
+    private fun shard(key: String): MMKVImpl = shards[shardIndex(key, shards.size)]
+
+    // 各分片在公共线程池上并行处理，调用方等待全部完成
+    private fun <T> onAllShards(block: (MMKVImpl) -> T): List<T> {
+        return shards.map { CompletableFuture.supplyAsync { block(it) } }.map { it.join() }
+    }
+
+    override fun set(key: String, value: String): Boolean = shard(key).set(key, value)
+
+    override fun set(key: String, value: Boolean): Boolean = shard(key).set(key, value)
+
+    override fun set(key: String, value: Int): Boolean = shard(key).set(key, value)
+
+    override fun set(key: String, value: Long): Boolean = shard(key).set(key, value)
+
+    override fun set(key: String, value: Float): Boolean = shard(key).set(key, value)
+
+    override fun set(key: String, value: Double): Boolean = shard(key).set(key, value)
+
+    override fun set(key: String, value: ByteArray): Boolean = shard(key).set(key, value)
+
+    override fun set(key: String, value: UInt): Boolean = shard(key).set(key, value)
+
+    override fun set(key: String, value: ULong): Boolean = shard(key).set(key, value)
+
+    override fun set(key: String, value: Set<String>?): Boolean = shard(key).set(key, value)
+
+    override fun setAll(values: Map<String, Any?>): Boolean {
+        val groups = values.entries.groupBy({ shardIndex(it.key, shards.size) }, { it.toPair() })
+        if (groups.size == 1) {
+            val (index, entries) = groups.entries.single()
+            return shards[index].setAll(entries.toMap())
+        }
+        return groups.map { (index, entries) ->
+            CompletableFuture.supplyAsync { shards[index].setAll(entries.toMap()) }
+        }.map { it.join() }.all { it }
+    }
+
+    @Deprecated(
+        message = "Renamed to 'getString' for clarity, as the 'take' prefix could be confusing.",
+        replaceWith = ReplaceWith("getString(key, default)")
+    )
+    override fun takeString(key: String, default: String): String = getString(key, default)
+
+    @Deprecated(
+        message = "Renamed to 'getBoolean' for clarity, as the 'take' prefix could be confusing.",
+        replaceWith = ReplaceWith("getBoolean(key, default)")
+    )
+    override fun takeBoolean(key: String, default: Boolean): Boolean = getBoolean(key, default)
+
+    @Deprecated(
+        message = "Renamed to 'getInt' for clarity, as the 'take' prefix could be confusing.",
+        replaceWith = ReplaceWith("getInt(key, default)")
+    )
+    override fun takeInt(key: String, default: Int): Int = getInt(key, default)
+
+    @Deprecated(
+        message = "Renamed to 'getLong' for clarity, as the 'take' prefix could be confusing.",
+        replaceWith = ReplaceWith("getLong(key, default)")
+    )
+    override fun takeLong(key: String, default: Long): Long = getLong(key, default)
+
+    @Deprecated(
+        message = "Renamed to 'getFloat' for clarity, as the 'take' prefix could be confusing.",
+        replaceWith = ReplaceWith("getFloat(key, default)")
+    )
+    override fun takeFloat(key: String, default: Float): Float = getFloat(key, default)
+
+    @Deprecated(
+        message = "Renamed to 'getDouble' for clarity, as the 'take' prefix could be confusing.",
+        replaceWith = ReplaceWith("getDouble(key, default)")
+    )
+    override fun takeDouble(key: String, default: Double): Double = getDouble(key, default)
+
+    @Deprecated(
+        message = "Renamed to 'getByteArray' for clarity, as the 'take' prefix could be confusing.",
+        replaceWith = ReplaceWith("getByteArray(key, default)")
+    )
+    override fun takeByteArray(key: String, default: ByteArray?): ByteArray? = getByteArray(key, default)
+
+    @Deprecated(
+        message = "Renamed to 'getUInt' for clarity, as the 'take' prefix could be confusing.",
+        replaceWith = ReplaceWith("getUInt(key, default)")
+    )
+    override fun takeUInt(key: String, default: UInt): UInt = getUInt(key, default)
+
+    @Deprecated(
+        message = "Renamed to 'getULong' for clarity, as the 'take' prefix could be confusing.",
+        replaceWith = ReplaceWith("getULong(key, default)")
+    )
+    override fun takeULong(key: String, default: ULong): ULong = getULong(key, default)
+
+    @Deprecated(
+        message = "Renamed to 'getStringSet' for clarity, as the 'take' prefix could be confusing.",
+        replaceWith = ReplaceWith("getStringSet(key, default)")
+    )
+    override fun takeStringSet(key: String, default: Set<String>?): Set<String>? = getStringSet(key, default)
+
+    override fun getString(key: String, default: String): String = shard(key).getString(key, default)
+
+    override fun getBoolean(key: String, default: Boolean): Boolean = shard(key).getBoolean(key, default)
+
+    override fun getInt(key: String, default: Int): Int = shard(key).getInt(key, default)
+
+    override fun getLong(key: String, default: Long): Long = shard(key).getLong(key, default)
+
+    override fun getFloat(key: String, default: Float): Float = shard(key).getFloat(key, default)
+
+    override fun getDouble(key: String, default: Double): Double = shard(key).getDouble(key, default)
+
+    override fun getByteArray(key: String, default: ByteArray?): ByteArray? = shard(key).getByteArray(key, default)
+
+    override fun getByteArray(key: String, buffer: ByteArray, offset: Int): Int =
+        shard(key).getByteArray(key, buffer, offset)
+
+    override fun getUInt(key: String, default: UInt): UInt = shard(key).getUInt(key, default)
+
+    override fun getULong(key: String, default: ULong): ULong = shard(key).getULong(key, default)
+
+    override fun getStringSet(key: String, default: Set<String>?): Set<String>? =
+        shard(key).getStringSet(key, default)
+
+    override fun getAll(defaults: Map<String, Any>): Map<String, Any> {
+        val result = HashMap<String, Any>(defaults.size)
+        defaults.entries.groupBy({ shardIndex(it.key, shards.size) }, { it.toPair() }).forEach { (index, entries) ->
+            result.putAll(shards[index].getAll(entries.toMap()))
+        }
+        // 保持与 defaults 相同的顺序
+        return defaults.keys.associateWith { result.getValue(it) }
+    }
+
+    override fun removeValueForKey(key: String) {
+        shard(key).removeValueForKey(key)
+    }
+
+    override fun removeValuesForKeys(keys: List<String>) {
+        keys.groupBy { shardIndex(it, shards.size) }.forEach { (index, group) ->
+            shards[index].removeValuesForKeys(group)
+        }
+    }
+
+    override val actualSize: Long
+        get() = shards.sumOf { it.actualSize }
+    override val count: Long
+        get() = shards.sumOf { it.count }
+    override val totalSize: Long
+        get() = shards.sumOf { it.totalSize }
+
+    override fun clearMemoryCache() {
+        shards.forEach { it.clearMemoryCache() }
+    }
+
+    override fun clearAll() {
+        onAllShards { it.clearAll() }
+    }
+
+    override fun close() {
+        shards.forEach { it.close() }
+    }
+
+    override fun allKeys(): List<String> = shards.flatMap { it.allKeys() }
+
+    override fun keys(prefix: String, batchSize: Int): Sequence<String> {
+        require(batchSize > 0) { "batchSize must be positive, was $batchSize" }
+        return shards.asSequence().flatMap { it.keys(prefix, batchSize) }
+    }
+
+    override fun keysFlow(prefix: String, batchSize: Int): Flow<String> {
+        require(batchSize > 0) { "batchSize must be positive, was $batchSize" }
+        return flow {
+            shards.forEach { emitAll(it.keysFlow(prefix, batchSize)) }
+        }
+    }
+
+    override fun containsKey(key: String): Boolean = shard(key).containsKey(key)
+
+    override fun checkReSetCryptKey(key: String?) {
+        shards.forEach { it.checkReSetCryptKey(key) }
+    }
+
+    override fun mmapID(): String = mmapId
+
+    override fun async() {
+        shards.forEach { it.async() }
+    }
+
+    override fun sync() {
+        onAllShards { it.sync() }
+    }
+
+    /**
+     * Compact all shards at once, each on its own thread
+     */
+    override fun trim() {
+        onAllShards { it.trim() }
+    }
+
+    internal companion object {
+        private const val SHARD_COUNT_KEY = "shardCount"
+        // 正在切换到的分片数，存在时说明上次重新分布在暂存完成后中断
+        private const val RESHARD_TARGET_KEY = "reshardTarget"
+
+        private fun metaId(mmapId: String) = "$mmapId.shards"
+
+        private fun shardId(mmapId: String, index: Int) = "$mmapId.shard-$index"
+
+        private fun stagingId(mmapId: String, index: Int) = "$mmapId.reshard-$index"
+
+        // FNV-1a，不依赖 String.hashCode 与进程，保证同一个 key 始终落在同一个分片
+        fun shardIndex(key: String, shardCount: Int): Int {
+            var hash = 0x811c9dc5.toInt()
+            for (byte in key.encodeToByteArray()) {
+                hash = (hash xor (byte.toInt() and 0xff)) * 0x01000193
+            }
+            return Integer.remainderUnsigned(hash, shardCount)
+        }
+
+        fun open(
+            mmapId: String,
+            shardCount: Int,
+            mode: MMKVMode,
+            cryptKey: String?,
+            rootPath: String?,
+        ): MMKVSharded {
+            require(shardCount > 0) { "shardCount must be positive, was $shardCount" }
+            // 元数据实例与分片一样保持打开，同一进程内的其他 MMKVSharded 可能正在使用
+            val meta = mmkvWithID(metaId(mmapId), mode, null, rootPath) as MMKVImpl
+            finishReshard(mmapId, meta, mode, cryptKey, rootPath)
+            val stored = meta.getInt(SHARD_COUNT_KEY, 0)
+            if (stored == 0) {
+                meta[SHARD_COUNT_KEY] = shardCount
+            } else {
+                check(stored == shardCount) {
+                    "$mmapId has $stored shards, call reshardMMKV to change it to $shardCount"
+                }
+            }
+            // 各分片在后台线程上并发打开
+            val shards = List(shardCount) {
+                CompletableFuture.supplyAsync { mmkvWithID(shardId(mmapId, it), mode, cryptKey, rootPath) }
+            }.map { it.join() as MMKVImpl }
+            return MMKVSharded(mmapId, shards)
+        }
+
+        fun reshard(
+            mmapId: String,
+            shardCount: Int,
+            mode: MMKVMode,
+            cryptKey: String?,
+            rootPath: String?,
+        ) {
+            require(shardCount > 0) { "shardCount must be positive, was $shardCount" }
+            val importFrom = NativeMMKV.importFrom
+                ?: throw UnsupportedOperationException("mmkv_importFrom is not available in this native library")
+            val meta = mmkvWithID(metaId(mmapId), mode, null, rootPath) as MMKVImpl
+            finishReshard(mmapId, meta, mode, cryptKey, rootPath)
+            val current = meta.getInt(SHARD_COUNT_KEY, 0)
+            if (current == 0) {
+                meta[SHARD_COUNT_KEY] = shardCount
+                return
+            }
+            if (current == shardCount) {
+                return
+            }
+
+            // 先在暂存实例中按新的分片数建好全部数据，原分片保持不变，中断后重来即可
+            val sources = List(current) { mmkvWithID(shardId(mmapId, it), mode, cryptKey, rootPath) as MMKVImpl }
+            val targets = sources.map { source -> source.allKeys().groupBy { shardIndex(it, shardCount) } }
+            List(shardCount) { index ->
+                CompletableFuture.runAsync {
+                    val staging = mmkvWithID(stagingId(mmapId, index), mode, cryptKey, rootPath) as MMKVImpl
+                    staging.clearAll()
+                    // MMKV 只能整个实例导入，导入后删去不属于这个分片的 key
+                    sources.forEachIndexed { source, instance ->
+                        if (targets[source].containsKey(index)) {
+                            importFrom(staging.ptr, instance.ptr)
+                            staging.removeValuesForKeys(targets[source].filterKeys { it != index }.values.flatten())
+                        }
+                    }
+                    staging.trim()
+                    staging.sync()
+                }
+            }.forEach { it.join() }
+            sources.forEach { it.close() }
+
+            meta[RESHARD_TARGET_KEY] = shardCount
+            meta.sync()
+            finishReshard(mmapId, meta, mode, cryptKey, rootPath)
+        }
+
+        // 用暂存实例替换分片，可以重复执行，中断后在下次打开时继续
+        private fun finishReshard(
+            mmapId: String,
+            meta: MMKVImpl,
+            mode: MMKVMode,
+            cryptKey: String?,
+            rootPath: String?,
+        ) {
+            val target = meta.getInt(RESHARD_TARGET_KEY, 0)
+            if (target == 0) {
+                return
+            }
+            val importFrom = NativeMMKV.importFrom
+                ?: throw UnsupportedOperationException("mmkv_importFrom is not available in this native library")
+            val removeStorage = NativeMMKV.removeStorage
+                ?: throw UnsupportedOperationException("mmkv_removeStorage is not available in this native library")
+            val current = meta.getInt(SHARD_COUNT_KEY, 0)
+            List(target) { index ->
+                CompletableFuture.runAsync {
+                    val staging = mmkvWithID(stagingId(mmapId, index), mode, cryptKey, rootPath) as MMKVImpl
+                    val shard = mmkvWithID(shardId(mmapId, index), mode, cryptKey, rootPath) as MMKVImpl
+                    shard.clearAll()
+                    importFrom(shard.ptr, staging.ptr)
+                    shard.sync()
+                    shard.close()
+                    staging.close()
+                }
+            }.forEach { it.join() }
+            for (index in target until current) {
+                removeStorage(shardId(mmapId, index), rootPath)
+            }
+
+            meta[SHARD_COUNT_KEY] = target
+            meta.removeValueForKey(RESHARD_TARGET_KEY)
+            meta.sync()
+            for (index in 0 until target) {
+                removeStorage(stagingId(mmapId, index), rootPath)
+            }
+        }
+    }
+}
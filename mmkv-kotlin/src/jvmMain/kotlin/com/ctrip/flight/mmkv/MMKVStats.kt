@@ -0,0 +1,51 @@
+package com.ctrip.flight.mmkv
+
+import kotlin.math.ceil
+
+/**
+ * Counters of an instance since its stats were enabled, see [MMKVImpl.enableStats].
+ * [bytesAppended], [fullWritebacks] and [fileExpansions] are inferred from the file size around each write,
+ * so they are approximate when several threads write at the same time.
+ * [lockWaitNanos] only covers the inter-process lock taken by batch reads/writes and write-behind flushes.
+ * In the latency histograms, index i counts operations that took [2^i, 2^(i+1)) nanoseconds
+ */
+data class MMKVStats(
+    val reads: Long,
+    val writes: Long,
+    val bytesAppended: Long,
+    val fullWritebacks: Long,
+    val fileExpansions: Long,
+    val trims: Long,
+    val reloads: Long,
+    val crcFailures: Long,
+    val lockWaitNanos: Long,
+    val getLatency: List<Long>,
+    val setLatency: List<Long>,
+) {
+    /**
+     * Upper bound in nanoseconds of the [percentile] (0..100) of [getLatency], 0 if there is no read
+     */
+    fun getLatencyPercentile(percentile: Double): Long = percentileOf(getLatency, percentile)
+
+    /**
+     * Upper bound in nanoseconds of the [percentile] (0..100) of [setLatency], 0 if there is no write
+     */
+    fun setLatencyPercentile(percentile: Double): Long = percentileOf(setLatency, percentile)
+
+    private fun percentileOf(histogram: List<Long>, percentile: Double): Long {
+        require(percentile in 0.0..100.0) { "percentile must be in 0..100, was $percentile" }
+        val total = histogram.sum()
+        if (total == 0L) {
+            return 0
+        }
+        val target = maxOf(1L, ceil(total * percentile / 100).toLong())
+        var seen = 0L
+        histogram.forEachIndexed { bucket, count ->
+            seen += count
+            if (seen >= target) {
+                return 1L shl (bucket + 1)
+            }
+        }
+        return 1L shl histogram.size
+    }
+}
@@ -0,0 +1,46 @@
+package com.ctrip.flight.mmkv
+
+import java.lang.foreign.MemorySegment
+
+/**
+ * Changes staged in native memory by [MMKVImpl.transaction]. Nothing is written to the instance until
+ * the transaction block returns; reads inside the block still see the values from before it
+ */
+class MMKVTransaction internal constructor(private val handle: MemorySegment) {
+
+    private var count = 0L
+
+    operator fun set(key: String, value: Boolean) = put(key, value)
+
+    operator fun set(key: String, value: Int) = put(key, value)
+
+    operator fun set(key: String, value: UInt) = put(key, value)
+
+    operator fun set(key: String, value: Long) = put(key, value)
+
+    operator fun set(key: String, value: ULong) = put(key, value)
+
+    operator fun set(key: String, value: Float) = put(key, value)
+
+    operator fun set(key: String, value: Double) = put(key, value)
+
+    operator fun set(key: String, value: String) = put(key, value)
+
+    operator fun set(key: String, value: ByteArray) = put(key, value)
+
+    fun removeValueForKey(key: String) = put(key, null)
+
+    private fun put(key: String, value: Any?) {
+        val put = NativeMMKV.txnPut!!
+        check(put(handle, BatchRecord.of(key, value))) { "Failed to stage $key" }
+        count++
+    }
+
+    internal fun commit(): Boolean {
+        return NativeMMKV.txnCommit!!(handle) == count
+    }
+
+    internal fun abort() {
+        NativeMMKV.txnAbort!!(handle)
+    }
+}
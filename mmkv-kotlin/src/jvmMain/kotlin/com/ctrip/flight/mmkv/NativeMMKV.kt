@@ -5,6 +5,7 @@ import java.lang.foreign.*
 import java.lang.foreign.ValueLayout.*
 import java.lang.invoke.MethodHandles
 import java.lang.invoke.MethodType
+import java.util.concurrent.ConcurrentHashMap
 import kotlin.getValue
 
 
@@ -12,6 +13,22 @@ internal fun interface MMKVInternalLog {
     fun invoke(level: Int, tag: MemorySegment, message: MemorySegment): Int
 }
 
+internal fun interface MMKVInternalLogBatch {
+    fun invoke(records: MemorySegment, count: Long)
+}
+
+internal fun interface MMKVInternalPreloadCallback {
+    fun invoke(index: Long, mmkv: MemorySegment)
+}
+
+internal fun interface MMKVInternalReKeyCallback {
+    fun invoke(mmkv: MemorySegment, stage: Int)
+}
+
+internal fun interface MMKVInternalChangeCallback {
+    fun invoke(context: MemorySegment, key: MemorySegment, keySize: Long)
+}
+
 internal object NativeMMKV {
     internal var global by atomic<Arena?>(null)
     internal var dll by atomic<SymbolLookup?>(null)
@@ -23,6 +40,41 @@ internal object NativeMMKV {
         JAVA_LONG.withName("size"),
     )
 
+    // 与 native 侧 MMKVStats 保持一致
+    private const val LATENCY_BUCKETS = 32L
+
+    val MMKV_STATS_STRUCT: StructLayout = MemoryLayout.structLayout(
+        JAVA_LONG.withName("reads"),
+        JAVA_LONG.withName("writes"),
+        JAVA_LONG.withName("bytesAppended"),
+        JAVA_LONG.withName("fullWritebacks"),
+        JAVA_LONG.withName("fileExpansions"),
+        JAVA_LONG.withName("trims"),
+        JAVA_LONG.withName("reloads"),
+        JAVA_LONG.withName("crcFailures"),
+        JAVA_LONG.withName("lockWaitNanos"),
+        MemoryLayout.sequenceLayout(LATENCY_BUCKETS, JAVA_LONG).withName("getLatency"),
+        MemoryLayout.sequenceLayout(LATENCY_BUCKETS, JAVA_LONG).withName("setLatency"),
+    )
+
+    // 与 native 侧 MMKVMemoryBudgetState 保持一致
+    val MMKV_MEMORY_BUDGET_STRUCT: StructLayout = MemoryLayout.structLayout(
+        JAVA_LONG.withName("budgetBytes"),
+        JAVA_LONG.withName("residentBytes"),
+        JAVA_LONG.withName("instances"),
+        JAVA_LONG.withName("residentInstances"),
+        JAVA_LONG.withName("evictions"),
+    )
+
+    // 与 native 侧 LogRecord 保持一致
+    val MMKV_LOG_RECORD_STRUCT: StructLayout = MemoryLayout.structLayout(
+        JAVA_INT.withName("level"),
+        JAVA_INT.withName("line"),
+        ADDRESS.withName("file"),
+        ADDRESS.withName("function"),
+        ADDRESS.withName("message"),
+    )
+
     val initialize: (String, Int, (Int, String, String) -> Unit) -> Unit by lazy {
         val funcHandle = Linker.nativeLinker().downcallHandle(
             dll!!.find("mmkv_initialize").orElseThrow(),
@@ -65,6 +117,63 @@ internal object NativeMMKV {
         }
     }
 
+    /**
+     * 日志在 native 侧按级别过滤后按批回调，并带上 file/line/function；
+     * async 为 true 时日志全部由后台线程投递。当前 native 库未提供时为 null
+     */
+    val initializeWithLogHandler: ((String, Int, Boolean, (Int, String, Int, String, String) -> Unit) -> Unit)? by lazy {
+        val symbol = findOrNull("mmkv_initializeWithLogHandler") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.ofVoid(ADDRESS, JAVA_INT, ADDRESS, JAVA_BOOLEAN)
+        )
+
+        val adapter = MethodHandles.lookup().findVirtual(
+            MMKVInternalLogBatch::class.java,
+            "invoke",
+            MethodType.methodType(
+                Void.TYPE,
+                MemorySegment::class.java,
+                Long::class.java
+            )
+        )
+        fun offsetOf(name: String) = MMKV_LOG_RECORD_STRUCT.byteOffset(MemoryLayout.PathElement.groupElement(name))
+        val levelOffset = offsetOf("level")
+        val lineOffset = offsetOf("line")
+        val fileOffset = offsetOf("file")
+        val functionOffset = offsetOf("function")
+        val messageOffset = offsetOf("message")
+
+        return@lazy { path, logLevel, async, logFunc ->
+            val loggerStub = Linker.nativeLinker().upcallStub(
+                adapter.bindTo(
+                    MMKVInternalLogBatch { records0, count ->
+                        val records = records0.reinterpret(count * MMKV_LOG_RECORD_STRUCT.byteSize())
+                        for (i in 0 until count) {
+                            val record = records.asSlice(i * MMKV_LOG_RECORD_STRUCT.byteSize())
+                            logFunc(
+                                record.get(JAVA_INT, levelOffset),
+                                record.get(ADDRESS, fileOffset).reinterpret(Long.MAX_VALUE).getString(0),
+                                record.get(JAVA_INT, lineOffset),
+                                record.get(ADDRESS, functionOffset).reinterpret(Long.MAX_VALUE).getString(0),
+                                record.get(ADDRESS, messageOffset).reinterpret(Long.MAX_VALUE).getString(0),
+                            )
+                        }
+                    }
+                ),
+                FunctionDescriptor.ofVoid(
+                    ADDRESS, // LogRecord* records
+                    JAVA_LONG // size_t count
+                ),
+                global,
+            )
+            useArena {
+                val cPath = allocateFrom(path)
+                funcHandle.invoke(cPath, logLevel, loggerStub, async)
+            }
+        }
+    }
+
     val defaultMMKV: (Int, String?) -> MMKV_KMP by lazy {
         val funcHandle = Linker.nativeLinker().downcallHandle(
             dll!!.find("mmkv_defaultMMKV").orElseThrow(),
@@ -77,7 +186,7 @@ internal object NativeMMKV {
                 funcHandle.invoke(mode, cCryptKey) as? MemorySegment
                     ?: error("defaultMMKV return null")
             }
-            MMKVImpl(ptr)
+            MMKVImpl(ptr, mode == MMKVMode.MULTI_PROCESS.rawValue)
         }
     }
 
@@ -95,7 +204,45 @@ internal object NativeMMKV {
                 funcHandle.invoke(cId, mode, cCryptKey, cRootPath) as? MemorySegment
                     ?: error("mmkvWithID return null")
             }
-            MMKVImpl(ptr)
+            MMKVImpl(ptr, mode == MMKVMode.MULTI_PROCESS.rawValue)
+        }
+    }
+
+    /**
+     * 在 native 线程池上并发打开实例，阻塞到全部打开为止；每打开一个即在 native 工作线程上回调
+     * onOpened(下标, 句柄)，打开失败时句柄为 NULL。当前 native 库未提供时为 null
+     */
+    val preload: ((List<String>, List<Int>, Int, (Int, MemorySegment) -> Unit) -> Unit)? by lazy {
+        val symbol = findOrNull("mmkv_preload") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(JAVA_LONG, ADDRESS, ADDRESS, JAVA_LONG, JAVA_LONG, ADDRESS, ADDRESS)
+        )
+
+        val adapter = MethodHandles.lookup().findVirtual(
+            MMKVInternalPreloadCallback::class.java,
+            "invoke",
+            MethodType.methodType(Void.TYPE, Long::class.java, MemorySegment::class.java)
+        )
+
+        return@lazy { ids, modes, threads, onOpened ->
+            // 回调来自 native 工作线程，需要共享 Arena
+            Arena.ofShared().use { arena ->
+                val cIds = arena.allocate(ADDRESS, ids.size.toLong())
+                ids.forEachIndexed { i, id -> cIds.setAtIndex(ADDRESS, i.toLong(), arena.allocateFrom(id)) }
+                val cModes = arena.allocate(JAVA_INT, modes.size.toLong())
+                modes.forEachIndexed { i, mode -> cModes.setAtIndex(JAVA_INT, i.toLong(), mode) }
+                val out = arena.allocate(ADDRESS, ids.size.toLong())
+                val callbackStub = Linker.nativeLinker().upcallStub(
+                    adapter.bindTo(MMKVInternalPreloadCallback { index, mmkv -> onOpened(index.toInt(), mmkv) }),
+                    FunctionDescriptor.ofVoid(
+                        JAVA_LONG, // size_t index
+                        ADDRESS    // MMKV* mmkv
+                    ),
+                    arena,
+                )
+                funcHandle.invoke(cIds, cModes, ids.size.toLong(), threads.toLong(), out, callbackStub)
+            }
         }
     }
 
@@ -127,7 +274,22 @@ internal object NativeMMKV {
         }
     }
 
+    /**
+     * 按显式长度读取字符串：UTF-8 字节直接写入线程私有的缓冲区，不经过 strlen 与 free，支持内嵌的 '\u0000'；
+     * 当前 native 库未提供 mmkv_readValueInto 时退化为 [getCString]
+     */
     val getString: (MemorySegment, String, String) -> String by lazy {
+        val readInto = NativeMMKV.readValueInto ?: return@lazy getCString
+
+        return@lazy { mmkv, key, default ->
+            readIntoScratch { readInto(mmkv, key, it) }?.toArray(JAVA_BYTE)?.decodeToString() ?: default
+        }
+    }
+
+    /**
+     * 以 '\0' 结尾的字符串读取，返回值由 native malloc，需要再调用一次 free
+     */
+    val getCString: (MemorySegment, String, String) -> String by lazy {
         val funcHandle = Linker.nativeLinker().downcallHandle(
             dll!!.find("getString").orElseThrow(),
             FunctionDescriptor.of(ADDRESS, ADDRESS, ADDRESS, ADDRESS)
@@ -145,7 +307,29 @@ internal object NativeMMKV {
             str
         }
     }
+    /**
+     * 按显式长度写入字符串，支持内嵌的 '\u0000'；当前 native 库未提供 mmkv_setStringWithLength 时退化为 [setCString]
+     */
     val setString: (MemorySegment, String, String) -> Boolean by lazy {
+        val symbol = findOrNull("mmkv_setStringWithLength") ?: return@lazy setCString
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, ADDRESS, ADDRESS, JAVA_LONG)
+        )
+
+        return@lazy { mmkv, key, value ->
+            val bytes = value.encodeToByteArray()
+            val result = useArena {
+                val cKey = allocateFrom(key)
+                val cValue = allocate(bytes.size.toLong())
+                MemorySegment.copy(bytes, 0, cValue, JAVA_BYTE, 0, bytes.size)
+                funcHandle.invoke(mmkv, cKey, cValue, bytes.size.toLong())
+            }
+            result as Boolean
+        }
+    }
+
+    val setCString: (MemorySegment, String, String) -> Boolean by lazy {
         val funcHandle = Linker.nativeLinker().downcallHandle(
             dll!!.find("setString").orElseThrow(),
             FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, ADDRESS, ADDRESS)
@@ -312,6 +496,43 @@ internal object NativeMMKV {
         }
     }
 
+    /**
+     * 值的实际字节长度，key 不存在时返回 -1；当前 native 库未提供 mmkv_valueSize 时为 null
+     */
+    val valueSize: ((MemorySegment, String) -> Long)? by lazy {
+        val symbol = findOrNull("mmkv_valueSize") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(JAVA_LONG, ADDRESS, ADDRESS)
+        )
+
+        return@lazy { mmkv, key ->
+            useArena {
+                val keyPtr = allocateFrom(key)
+                funcHandle.invoke(mmkv, keyPtr) as Long
+            }
+        }
+    }
+
+    /**
+     * 将值直接写入 native 内存 dst，仅在 dst 容量足够时写入，返回值的字节长度，key 不存在时返回 -1；
+     * 当前 native 库未提供 mmkv_readValueInto 时为 null
+     */
+    val readValueInto: ((MemorySegment, String, MemorySegment) -> Long)? by lazy {
+        val symbol = findOrNull("mmkv_readValueInto") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(JAVA_LONG, ADDRESS, ADDRESS, ADDRESS, JAVA_LONG)
+        )
+
+        return@lazy { mmkv, key, dst ->
+            useArena {
+                val keyPtr = allocateFrom(key)
+                funcHandle.invoke(mmkv, keyPtr, dst, dst.byteSize()) as Long
+            }
+        }
+    }
+
     val getUInt: (MemorySegment, String, UInt) -> UInt by lazy {
         val funcHandle = Linker.nativeLinker().downcallHandle(
             dll!!.find("getUInt").orElseThrow(),
@@ -368,7 +589,37 @@ internal object NativeMMKV {
         }
     }
 
+    /**
+     * 以紧凑格式读取字符串集合，一次 malloc、一次 free；当前 native 库未提供时退化为 [getStringSetLegacy]
+     */
     val getStringSet: (MemorySegment, String, Set<String>?) -> Set<String>? by lazy {
+        val symbol = findOrNull("mmkv_getStringSetPacked") ?: return@lazy getStringSetLegacy
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(ADDRESS, ADDRESS, ADDRESS, ADDRESS)
+        )
+
+        return@lazy { mmkv, key, default ->
+            useArena {
+                val keyPtr = allocateFrom(key)
+                val sizePtr = allocate(JAVA_LONG)
+                val packed = funcHandle.invoke(mmkv, keyPtr, sizePtr) as MemorySegment
+                if (packed == MemorySegment.NULL) {
+                    default
+                } else {
+                    val result = PackedStringList.decode(
+                        packed.reinterpret(sizePtr.get(JAVA_LONG, 0)),
+                        LinkedHashSet<String>()
+                    )
+                    free(packed)
+                    result
+                }
+            }
+        }
+    }
+
+    // 每个字符串单独 malloc 的旧格式
+    val getStringSetLegacy: (MemorySegment, String, Set<String>?) -> Set<String>? by lazy {
         val funcHandle = Linker.nativeLinker().downcallHandle(
             dll!!.find("getStringSet").orElseThrow(),
             FunctionDescriptor.of(ADDRESS, ADDRESS, ADDRESS)
@@ -408,7 +659,30 @@ internal object NativeMMKV {
             }
         }
     }
+    /**
+     * 以紧凑格式写入字符串集合，value 为 null 时移除该 key；当前 native 库未提供时退化为 [setStringSetLegacy]
+     */
     val setStringSet: (MemorySegment, String, Set<String>?) -> Boolean by lazy {
+        val symbol = findOrNull("mmkv_setStringSetPacked") ?: return@lazy setStringSetLegacy
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, ADDRESS, ADDRESS, JAVA_LONG)
+        )
+
+        return@lazy { mmkv, key, value ->
+            useArena {
+                val keyPtr = allocateFrom(key)
+                if (value == null) {
+                    funcHandle.invoke(mmkv, keyPtr, MemorySegment.NULL, 0L) as Boolean
+                } else {
+                    val packed = PackedStringList.encode(this, value)
+                    funcHandle.invoke(mmkv, keyPtr, packed, packed.byteSize()) as Boolean
+                }
+            }
+        }
+    }
+
+    val setStringSetLegacy: (MemorySegment, String, Set<String>?) -> Boolean by lazy {
         val funcHandle = Linker.nativeLinker().downcallHandle(
             dll!!.find("setStringSet").orElseThrow(),
             FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, ADDRESS, ADDRESS, JAVA_LONG)
@@ -433,6 +707,150 @@ internal object NativeMMKV {
         }
     }
 
+    /**
+     * 批量写入，当前 native 库未提供 mmkv_setBatch 时为 null
+     */
+    val setBatch: ((MemorySegment, Map<String, Any?>) -> Boolean)? by lazy {
+        val symbol = findOrNull("mmkv_setBatch") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(JAVA_LONG, ADDRESS, ADDRESS, JAVA_LONG, JAVA_LONG)
+        )
+
+        return@lazy { mmkv, values ->
+            val records = values.map { (key, value) -> BatchRecord.of(key, value) }
+            if (records.isEmpty()) {
+                true
+            } else {
+                useArena {
+                    val segment = allocateBatch(records)
+                    val succeeded =
+                        funcHandle.invoke(mmkv, segment, segment.byteSize(), records.size.toLong()) as Long
+                    succeeded == records.size.toLong()
+                }
+            }
+        }
+    }
+
+    /**
+     * 事务：begin 返回 native 侧的暂存区，put 每次暂存一条记录，commit 返回成功写入的条数（日志写入失败时为 -1），
+     * commit 与 abort 之后暂存区即被释放。当前 native 库未提供时为 null
+     */
+    val txnBegin: ((MemorySegment) -> MemorySegment)? by lazy {
+        val symbol = findOrNull("mmkv_txnBegin") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(ADDRESS, ADDRESS)
+        )
+
+        return@lazy { mmkv ->
+            funcHandle.invoke(mmkv) as MemorySegment
+        }
+    }
+
+    val txnPut: ((MemorySegment, BatchRecord) -> Boolean)? by lazy {
+        val symbol = findOrNull("mmkv_txnPut") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, JAVA_INT, ADDRESS, JAVA_LONG, JAVA_LONG, ADDRESS, JAVA_LONG)
+        )
+
+        return@lazy { txn, record ->
+            useArena {
+                val cKey = allocateFrom(JAVA_BYTE, *record.key)
+                val data = record.data
+                val cData = if (data != null && data.isNotEmpty()) allocateFrom(JAVA_BYTE, *data) else MemorySegment.NULL
+                funcHandle.invoke(
+                    txn, record.type.tag, cKey, record.key.size.toLong(), record.value, cData, (data?.size ?: 0).toLong()
+                ) as Boolean
+            }
+        }
+    }
+
+    val txnCommit: ((MemorySegment) -> Long)? by lazy {
+        val symbol = findOrNull("mmkv_txnCommit") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(JAVA_LONG, ADDRESS)
+        )
+
+        return@lazy { txn ->
+            funcHandle.invoke(txn) as Long
+        }
+    }
+
+    val txnAbort: ((MemorySegment) -> Unit)? by lazy {
+        val symbol = findOrNull("mmkv_txnAbort") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.ofVoid(ADDRESS)
+        )
+
+        return@lazy { txn ->
+            funcHandle.invoke(txn)
+        }
+    }
+
+    /**
+     * 批量读取，一次调用填充一块连续内存，当前 native 库未提供 mmkv_getBatch 时为 null
+     */
+    val getBatch: ((MemorySegment, Map<String, Any>) -> Map<String, Any>)? by lazy {
+        val symbol = findOrNull("mmkv_getBatch") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(JAVA_LONG, ADDRESS, ADDRESS, JAVA_LONG, JAVA_LONG, ADDRESS, JAVA_LONG)
+        )
+
+        return@lazy { mmkv, defaults ->
+            val records = defaults.map { (key, default) -> BatchRecord.query(key, default) }
+            if (records.isEmpty()) {
+                emptyMap()
+            } else {
+                useArena {
+                    val request = allocateBatch(records)
+                    val count = records.size.toLong()
+                    // 预估变长值的大小，不够时按 native 返回的实际大小重新分配
+                    var capacity = count * BatchRecord.RESULT_ENTRY_SIZE + records.count {
+                        it.type == NativeValueType.STRING || it.type == NativeValueType.BYTE_ARRAY
+                    } * 64L
+                    var out: MemorySegment
+                    var required: Long
+                    do {
+                        out = allocate(capacity, 8)
+                        required = funcHandle.invoke(mmkv, request, request.byteSize(), count, out, capacity) as Long
+                        check(required >= 0) { "getBatch received malformed records" }
+                        val fits = required <= capacity
+                        capacity = required
+                    } while (!fits)
+
+                    val result = LinkedHashMap<String, Any>(defaults.size)
+                    defaults.entries.forEachIndexed { index, (key, default) ->
+                        val entryOffset = index * BatchRecord.RESULT_ENTRY_SIZE
+                        result[key] = if (out.get(JAVA_INT, entryOffset) == 0) {
+                            default
+                        } else {
+                            val size = out.get(JAVA_INT, entryOffset + 4).toLong() and 0xFFFFFFFFL
+                            val value = out.get(JAVA_LONG, entryOffset + 8)
+                            when (records[index].type) {
+                                NativeValueType.BOOLEAN -> value != 0L
+                                NativeValueType.INT -> value.toInt()
+                                NativeValueType.UINT -> value.toInt().toUInt()
+                                NativeValueType.LONG -> value
+                                NativeValueType.ULONG -> value.toULong()
+                                NativeValueType.FLOAT -> Float.fromBits(value.toInt())
+                                NativeValueType.DOUBLE -> Double.fromBits(value)
+                                NativeValueType.STRING -> out.asSlice(value, size).toArray(JAVA_BYTE).decodeToString()
+                                NativeValueType.BYTE_ARRAY -> out.asSlice(value, size).toArray(JAVA_BYTE)
+                                NativeValueType.REMOVE -> default
+                            }
+                        }
+                    }
+                    result
+                }
+            }
+        }
+    }
+
     val removeValueForKey: (MemorySegment, String) -> Boolean by lazy {
         val funcHandle = Linker.nativeLinker().downcallHandle(
             dll!!.find("mmkv_removeValueForKey").orElseThrow(),
@@ -447,7 +865,29 @@ internal object NativeMMKV {
         }
     }
 
+    /**
+     * 以紧凑格式传入所有 key；当前 native 库未提供时退化为 [removeValuesForKeysLegacy]
+     */
     val removeValuesForKeys: (MemorySegment, List<String>) -> Boolean by lazy {
+        val symbol = findOrNull("mmkv_removeValuesForKeysPacked") ?: return@lazy removeValuesForKeysLegacy
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, ADDRESS, JAVA_LONG)
+        )
+
+        return@lazy { mmkv, keys ->
+            if (keys.isEmpty()) {
+                true
+            } else {
+                useArena {
+                    val packed = PackedStringList.encode(this, keys)
+                    funcHandle.invoke(mmkv, packed, packed.byteSize()) as Boolean
+                }
+            }
+        }
+    }
+
+    val removeValuesForKeysLegacy: (MemorySegment, List<String>) -> Boolean by lazy {
         val funcHandle = Linker.nativeLinker().downcallHandle(
             dll!!.find("mmkv_removeValuesForKeys").orElseThrow(),
             FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, ADDRESS, JAVA_LONG)
@@ -531,7 +971,271 @@ internal object NativeMMKV {
         }
     }
 
+    /**
+     * 开启或关闭 Stats，当前 native 库未提供时为 null
+     */
+    val enableStats: ((MemorySegment, Boolean) -> Unit)? by lazy {
+        val symbol = findOrNull("mmkv_enableStats") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.ofVoid(ADDRESS, JAVA_BOOLEAN)
+        )
+
+        return@lazy { mmkv, enable ->
+            funcHandle.invoke(mmkv, enable)
+        }
+    }
+
+    val setMemoryBudget: ((Long, Long) -> Unit)? by lazy {
+        val symbol = findOrNull("mmkv_setMemoryBudget") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.ofVoid(JAVA_LONG, JAVA_LONG)
+        )
+
+        return@lazy { budgetBytes, idleMillis ->
+            funcHandle.invoke(budgetBytes, idleMillis)
+        }
+    }
+
+    val enforceMemoryBudget: (() -> Long)? by lazy {
+        val symbol = findOrNull("mmkv_enforceMemoryBudget") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(JAVA_LONG)
+        )
+
+        return@lazy {
+            funcHandle.invoke() as Long
+        }
+    }
+
+    val memoryBudgetState: (() -> MMKVMemoryBudgetState)? by lazy {
+        val symbol = findOrNull("mmkv_memoryBudgetState") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.ofVoid(ADDRESS)
+        )
+        fun offsetOf(name: String) =
+            MMKV_MEMORY_BUDGET_STRUCT.byteOffset(MemoryLayout.PathElement.groupElement(name))
+
+        return@lazy {
+            useArena {
+                val out = allocate(MMKV_MEMORY_BUDGET_STRUCT)
+                funcHandle.invoke(out)
+                fun counter(name: String) = out.get(JAVA_LONG, offsetOf(name))
+                MMKVMemoryBudgetState(
+                    budgetBytes = counter("budgetBytes"),
+                    residentBytes = counter("residentBytes"),
+                    instances = counter("instances"),
+                    residentInstances = counter("residentInstances"),
+                    evictions = counter("evictions"),
+                )
+            }
+        }
+    }
+
+    /**
+     * 未开启 Stats 时返回 null
+     */
+    val stats: (MemorySegment) -> MMKVStats? by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("mmkv_stats").orElseThrow(),
+            FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, ADDRESS)
+        )
+        fun offsetOf(name: String) = MMKV_STATS_STRUCT.byteOffset(MemoryLayout.PathElement.groupElement(name))
+
+        return@lazy { mmkv ->
+            useArena {
+                val out = allocate(MMKV_STATS_STRUCT)
+                if (funcHandle.invoke(mmkv, out) as Boolean) {
+                    fun counter(name: String) = out.get(JAVA_LONG, offsetOf(name))
+                    fun histogram(name: String) =
+                        out.asSlice(offsetOf(name), LATENCY_BUCKETS * JAVA_LONG.byteSize()).toArray(JAVA_LONG).asList()
+                    MMKVStats(
+                        reads = counter("reads"),
+                        writes = counter("writes"),
+                        bytesAppended = counter("bytesAppended"),
+                        fullWritebacks = counter("fullWritebacks"),
+                        fileExpansions = counter("fileExpansions"),
+                        trims = counter("trims"),
+                        reloads = counter("reloads"),
+                        crcFailures = counter("crcFailures"),
+                        lockWaitNanos = counter("lockWaitNanos"),
+                        getLatency = histogram("getLatency"),
+                        setLatency = histogram("setLatency"),
+                    )
+                } else {
+                    null
+                }
+            }
+        }
+    }
+
+    /**
+     * 开启或关闭写后模式，当前 native 库未提供时为 null
+     */
+    val enableWriteBehind: ((MemorySegment, Boolean) -> Unit)? by lazy {
+        val symbol = findOrNull("mmkv_enableWriteBehind") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.ofVoid(ADDRESS, JAVA_BOOLEAN)
+        )
+
+        return@lazy { mmkv, enable ->
+            funcHandle.invoke(mmkv, enable)
+        }
+    }
+
+    /**
+     * 开启或关闭自动整理，参数依次为 enable、wasteRatio、idleMillis、maxFileSize。当前 native 库未提供时为 null
+     */
+    val enableAutoCompaction: ((MemorySegment, Boolean, Double, Long, Long) -> Unit)? by lazy {
+        val symbol = findOrNull("mmkv_enableAutoCompaction") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.ofVoid(ADDRESS, JAVA_BOOLEAN, JAVA_DOUBLE, JAVA_LONG, JAVA_LONG)
+        )
+
+        return@lazy { mmkv, enable, wasteRatio, idleMillis, maxFileSize ->
+            funcHandle.invoke(mmkv, enable, wasteRatio, idleMillis, maxFileSize)
+        }
+    }
+
+    val enableMergedCounters: ((MemorySegment, Boolean, Long) -> Unit)? by lazy {
+        val symbol = findOrNull("mmkv_enableMergedCounters") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.ofVoid(ADDRESS, JAVA_BOOLEAN, JAVA_LONG)
+        )
+
+        return@lazy { mmkv, enable, flushMillis ->
+            funcHandle.invoke(mmkv, enable, flushMillis)
+        }
+    }
+
+    val enableChangeNotify: ((MemorySegment, Boolean) -> Boolean)? by lazy {
+        val symbol = findOrNull("mmkv_enableChangeNotify") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, JAVA_BOOLEAN)
+        )
+
+        return@lazy { mmkv, enable ->
+            funcHandle.invoke(mmkv, enable) as Boolean
+        }
+    }
+
+    // 订阅的 context 为自增的 token，回调按 token 分发；先登记再订阅，不会漏掉订阅后立即发生的修改
+    private val changeHandlers = ConcurrentHashMap<Long, (String?) -> Unit>()
+    private val watchTokens = ConcurrentHashMap<Long, Long>()
+    private val nextWatchToken = atomic(1L)
+
+    /**
+     * 在 native 后台线程上订阅以 prefix 开头的 key 的修改（包括其他进程的写入），onChange 的参数为 null 表示未知的修改。
+     * 返回订阅 id，失败时返回 0。当前 native 库未提供时为 null
+     */
+    val watch: ((MemorySegment, String, (String?) -> Unit) -> Long)? by lazy {
+        val symbol = findOrNull("mmkv_watch") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(JAVA_LONG, ADDRESS, ADDRESS, JAVA_LONG, ADDRESS, ADDRESS)
+        )
+
+        val adapter = MethodHandles.lookup().findVirtual(
+            MMKVInternalChangeCallback::class.java,
+            "invoke",
+            MethodType.methodType(Void.TYPE, MemorySegment::class.java, MemorySegment::class.java, Long::class.java)
+        )
+        // 回调晚于调用返回，需放在全局 Arena
+        val callbackStub = Linker.nativeLinker().upcallStub(
+            adapter.bindTo(MMKVInternalChangeCallback { context, key, keySize ->
+                val changed = if (key == MemorySegment.NULL) {
+                    null
+                } else {
+                    key.reinterpret(keySize).toArray(JAVA_BYTE).decodeToString()
+                }
+                changeHandlers[context.address()]?.invoke(changed)
+            }),
+            FunctionDescriptor.ofVoid(
+                ADDRESS,   // void* context
+                ADDRESS,   // const char* key
+                JAVA_LONG, // size_t keySize
+            ),
+            global,
+        )
+
+        return@lazy { mmkv, prefix, onChange ->
+            useArena {
+                val prefixBytes = prefix.encodeToByteArray()
+                val prefixPtr = allocateFrom(JAVA_BYTE, *prefixBytes)
+                val token = nextWatchToken.getAndIncrement()
+                changeHandlers[token] = onChange
+                val id = funcHandle.invoke(
+                    mmkv, prefixPtr, prefixBytes.size.toLong(), callbackStub, MemorySegment.ofAddress(token)
+                ) as Long
+                if (id == 0L) {
+                    changeHandlers.remove(token)
+                } else {
+                    watchTokens[id] = token
+                }
+                id
+            }
+        }
+    }
+
+    val unwatch: ((Long) -> Unit)? by lazy {
+        val symbol = findOrNull("mmkv_unwatch") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.ofVoid(JAVA_LONG)
+        )
+
+        return@lazy { id ->
+            funcHandle.invoke(id)
+            watchTokens.remove(id)?.let { changeHandlers.remove(it) }
+        }
+    }
+
+    val flush: ((MemorySegment) -> Boolean)? by lazy {
+        val symbol = findOrNull("mmkv_flush") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS)
+        )
+
+        return@lazy { mmkv ->
+            funcHandle.invoke(mmkv) as Boolean
+        }
+    }
+
+    /**
+     * 以紧凑格式读取所有 key，一次 malloc、一次 free；当前 native 库未提供时退化为 [allKeysLegacy]
+     */
     val allKeys: (ptr: MemorySegment) -> List<String> by lazy {
+        val symbol = findOrNull("mmkv_allKeysPacked") ?: return@lazy allKeysLegacy
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(ADDRESS, ADDRESS, ADDRESS)
+        )
+
+        return@lazy { mmkv ->
+            useArena {
+                val sizePtr = allocate(JAVA_LONG)
+                val packed = funcHandle.invoke(mmkv, sizePtr) as MemorySegment
+                if (packed == MemorySegment.NULL) {
+                    error("allKeys return null")
+                }
+                val size = sizePtr.get(JAVA_LONG, 0)
+                val count = packed.reinterpret(JAVA_LONG.byteSize()).get(JAVA_LONG, 0)
+                val result = PackedStringList.decode(packed.reinterpret(size), ArrayList<String>(count.toInt()))
+                free(packed)
+                result
+            }
+        }
+    }
+
+    val allKeysLegacy: (ptr: MemorySegment) -> List<String> by lazy {
         val funcHandle = Linker.nativeLinker().downcallHandle(
             dll!!.find("mmkv_allKeys").orElseThrow(),
             FunctionDescriptor.of(ADDRESS, ADDRESS)
@@ -566,6 +1270,67 @@ internal object NativeMMKV {
         }
     }
 
+    /**
+     * 打开按前缀过滤的 key 游标，当前 native 库未提供时为 null
+     */
+    val iterOpen: ((MemorySegment, String) -> MemorySegment)? by lazy {
+        val symbol = findOrNull("mmkv_iterOpen") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(ADDRESS, ADDRESS, ADDRESS, JAVA_LONG)
+        )
+
+        return@lazy { mmkv, prefix ->
+            useArena {
+                val prefixBytes = prefix.encodeToByteArray()
+                val prefixPtr = allocateFrom(JAVA_BYTE, *prefixBytes)
+                funcHandle.invoke(mmkv, prefixPtr, prefixBytes.size.toLong()) as MemorySegment
+            }
+        }
+    }
+
+    /**
+     * 取出游标的下一批 key，遍历结束时返回 null
+     */
+    val iterNext: (MemorySegment, MemorySegment, Int, Boolean) -> KeyBatch? by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("mmkv_iterNext").orElseThrow(),
+            FunctionDescriptor.of(ADDRESS, ADDRESS, ADDRESS, JAVA_LONG, JAVA_BOOLEAN, ADDRESS)
+        )
+
+        return@lazy { mmkv, iter, batchSize, withValueSizes ->
+            useArena {
+                val sizePtr = allocate(JAVA_LONG)
+                val packed = funcHandle.invoke(mmkv, iter, batchSize.toLong(), withValueSizes, sizePtr) as MemorySegment
+                if (packed == MemorySegment.NULL) {
+                    null
+                } else {
+                    val segment = packed.reinterpret(sizePtr.get(JAVA_LONG, 0))
+                    val count = segment.get(JAVA_LONG, 0)
+                    val keys = PackedStringList.decode(segment, ArrayList<String>(count.toInt()))
+                    val valueSizes = if (withValueSizes) {
+                        segment.asSlice(PackedStringList.trailerOffset(segment)).toArray(JAVA_LONG)
+                    } else {
+                        null
+                    }
+                    free(packed)
+                    KeyBatch(keys, valueSizes)
+                }
+            }
+        }
+    }
+
+    val iterClose: (MemorySegment) -> Unit by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("mmkv_iterClose").orElseThrow(),
+            FunctionDescriptor.ofVoid(ADDRESS)
+        )
+
+        return@lazy { iter ->
+            funcHandle.invoke(iter)
+        }
+    }
+
     val containsKey: (ptr: MemorySegment, key: String) -> Boolean by lazy {
         val funcHandle = Linker.nativeLinker().downcallHandle(
             dll!!.find("mmkv_containsKey").orElseThrow(),
@@ -594,6 +1359,55 @@ internal object NativeMMKV {
         }
     }
 
+    /**
+     * 在 native 后台线程上换密钥，按阶段回调 onStage(MMKVReKeyStage.ordinal)，最后一次为 FINISHED 或 FAILED。
+     * 多进程实例或已有换密钥在进行时返回 false。当前 native 库未提供时为 null
+     */
+    val reKeyAsync: ((MemorySegment, String?, String?, (Int) -> Unit) -> Boolean)? by lazy {
+        val symbol = findOrNull("mmkv_reKeyAsync") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, ADDRESS, JAVA_LONG, ADDRESS, ADDRESS)
+        )
+
+        val adapter = MethodHandles.lookup().findVirtual(
+            MMKVInternalReKeyCallback::class.java,
+            "invoke",
+            MethodType.methodType(Void.TYPE, MemorySegment::class.java, Int::class.java)
+        )
+        // 所有实例共用一个 upcall，按实例地址分发；回调晚于调用返回，需放在全局 Arena
+        val handlers = ConcurrentHashMap<Long, (Int) -> Unit>()
+        val callbackStub = Linker.nativeLinker().upcallStub(
+            adapter.bindTo(MMKVInternalReKeyCallback { mmkv, stage ->
+                val handler = if (stage >= MMKVReKeyStage.FINISHED.ordinal) {
+                    handlers.remove(mmkv.address())
+                } else {
+                    handlers[mmkv.address()]
+                }
+                handler?.invoke(stage)
+            }),
+            FunctionDescriptor.ofVoid(
+                ADDRESS,  // MMKV* mmkv
+                JAVA_INT, // int32_t stage
+            ),
+            global,
+        )
+
+        return@lazy { mmkv, key, rootPath, onStage ->
+            useArena {
+                val keyBytes = key?.encodeToByteArray()
+                val keyPtr = if (keyBytes != null) allocateFrom(JAVA_BYTE, *keyBytes) else MemorySegment.NULL
+                val pathPtr = if (rootPath != null) allocateFrom(rootPath) else MemorySegment.NULL
+                handlers[mmkv.address()] = onStage
+                val started = funcHandle.invoke(mmkv, keyPtr, (keyBytes?.size ?: 0).toLong(), pathPtr, callbackStub) as Boolean
+                if (!started) {
+                    handlers.remove(mmkv.address(), onStage)
+                }
+                started
+            }
+        }
+    }
+
     val mmapID: (MemorySegment) -> String by lazy {
         val funcHandle = Linker.nativeLinker().downcallHandle(
             dll!!.find("mmkv_mmapID").orElseThrow(),
@@ -659,6 +1473,34 @@ internal object NativeMMKV {
         }
     }
 
+    val importFrom: ((MemorySegment, MemorySegment) -> Long)? by lazy {
+        val symbol = findOrNull("mmkv_importFrom") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(JAVA_LONG, ADDRESS, ADDRESS)
+        )
+
+        return@lazy { dst, src ->
+            funcHandle.invoke(dst, src) as Long
+        }
+    }
+
+    val removeStorage: ((String, String?) -> Boolean)? by lazy {
+        val symbol = findOrNull("mmkv_removeStorage") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, ADDRESS)
+        )
+
+        return@lazy { mmapID, rootPath ->
+            useArena {
+                val cMmapID = allocateFrom(mmapID)
+                val cRootPath = if (rootPath != null) allocateFrom(rootPath) else MemorySegment.NULL
+                funcHandle.invoke(cMmapID, cRootPath) as Boolean
+            }
+        }
+    }
+
     val pageSize: () -> Long by lazy {
         val funcHandle = Linker.nativeLinker().downcallHandle(
             dll!!.find("mmkv_pageSize").orElseThrow(),
@@ -708,6 +1550,272 @@ internal object NativeMMKV {
         }
     }
 
+    /**
+     * 创建 KeyHandle，当前 native 库未提供 mmkv_keyHandle 时为 null
+     */
+    val keyHandle: ((String) -> MemorySegment)? by lazy {
+        val symbol = findOrNull("mmkv_keyHandle") ?: return@lazy null
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(ADDRESS, ADDRESS, JAVA_LONG)
+        )
+
+        return@lazy { key ->
+            val bytes = key.encodeToByteArray()
+            useArena {
+                val cKey = allocate(bytes.size.toLong())
+                MemorySegment.copy(bytes, 0, cKey, JAVA_BYTE, 0, bytes.size)
+                funcHandle.invoke(cKey, bytes.size.toLong()) as MemorySegment
+            }
+        }
+    }
+
+    val releaseKeyHandle: (MemorySegment) -> Unit by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("mmkv_releaseKeyHandle").orElseThrow(),
+            FunctionDescriptor.ofVoid(ADDRESS)
+        )
+
+        return@lazy { handle ->
+            funcHandle.invoke(handle)
+        }
+    }
+
+    val getIntByHandle: (MemorySegment, MemorySegment, Int) -> Int by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("getIntByHandle").orElseThrow(),
+            FunctionDescriptor.of(JAVA_INT, ADDRESS, ADDRESS, JAVA_INT)
+        )
+
+        return@lazy { mmkv, handle, default ->
+            funcHandle.invoke(mmkv, handle, default) as Int
+        }
+    }
+    val setIntByHandle: (MemorySegment, MemorySegment, Int) -> Boolean by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("setIntByHandle").orElseThrow(),
+            FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, ADDRESS, JAVA_INT)
+        )
+
+        return@lazy { mmkv, handle, value ->
+            funcHandle.invoke(mmkv, handle, value) as Boolean
+        }
+    }
+
+    val getUIntByHandle: (MemorySegment, MemorySegment, UInt) -> UInt by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("getUIntByHandle").orElseThrow(),
+            FunctionDescriptor.of(JAVA_INT, ADDRESS, ADDRESS, JAVA_INT)
+        )
+
+        return@lazy { mmkv, handle, default ->
+            (funcHandle.invoke(mmkv, handle, default.toInt()) as Int).toUInt()
+        }
+    }
+    val setUIntByHandle: (MemorySegment, MemorySegment, UInt) -> Boolean by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("setUIntByHandle").orElseThrow(),
+            FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, ADDRESS, JAVA_INT)
+        )
+
+        return@lazy { mmkv, handle, value ->
+            funcHandle.invoke(mmkv, handle, value.toInt()) as Boolean
+        }
+    }
+
+    val getLongByHandle: (MemorySegment, MemorySegment, Long) -> Long by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("getLongByHandle").orElseThrow(),
+            FunctionDescriptor.of(JAVA_LONG, ADDRESS, ADDRESS, JAVA_LONG)
+        )
+
+        return@lazy { mmkv, handle, default ->
+            funcHandle.invoke(mmkv, handle, default) as Long
+        }
+    }
+    val setLongByHandle: (MemorySegment, MemorySegment, Long) -> Boolean by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("setLongByHandle").orElseThrow(),
+            FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, ADDRESS, JAVA_LONG)
+        )
+
+        return@lazy { mmkv, handle, value ->
+            funcHandle.invoke(mmkv, handle, value) as Boolean
+        }
+    }
+
+    val getULongByHandle: (MemorySegment, MemorySegment, ULong) -> ULong by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("getULongByHandle").orElseThrow(),
+            FunctionDescriptor.of(JAVA_LONG, ADDRESS, ADDRESS, JAVA_LONG)
+        )
+
+        return@lazy { mmkv, handle, default ->
+            (funcHandle.invoke(mmkv, handle, default.toLong()) as Long).toULong()
+        }
+    }
+    val setULongByHandle: (MemorySegment, MemorySegment, ULong) -> Boolean by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("setULongByHandle").orElseThrow(),
+            FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, ADDRESS, JAVA_LONG)
+        )
+
+        return@lazy { mmkv, handle, value ->
+            funcHandle.invoke(mmkv, handle, value.toLong()) as Boolean
+        }
+    }
+
+    val getFloatByHandle: (MemorySegment, MemorySegment, Float) -> Float by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("getFloatByHandle").orElseThrow(),
+            FunctionDescriptor.of(JAVA_FLOAT, ADDRESS, ADDRESS, JAVA_FLOAT)
+        )
+
+        return@lazy { mmkv, handle, default ->
+            funcHandle.invoke(mmkv, handle, default) as Float
+        }
+    }
+    val setFloatByHandle: (MemorySegment, MemorySegment, Float) -> Boolean by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("setFloatByHandle").orElseThrow(),
+            FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, ADDRESS, JAVA_FLOAT)
+        )
+
+        return@lazy { mmkv, handle, value ->
+            funcHandle.invoke(mmkv, handle, value) as Boolean
+        }
+    }
+
+    val getDoubleByHandle: (MemorySegment, MemorySegment, Double) -> Double by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("getDoubleByHandle").orElseThrow(),
+            FunctionDescriptor.of(JAVA_DOUBLE, ADDRESS, ADDRESS, JAVA_DOUBLE)
+        )
+
+        return@lazy { mmkv, handle, default ->
+            funcHandle.invoke(mmkv, handle, default) as Double
+        }
+    }
+    val setDoubleByHandle: (MemorySegment, MemorySegment, Double) -> Boolean by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("setDoubleByHandle").orElseThrow(),
+            FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, ADDRESS, JAVA_DOUBLE)
+        )
+
+        return@lazy { mmkv, handle, value ->
+            funcHandle.invoke(mmkv, handle, value) as Boolean
+        }
+    }
+
+    val getBooleanByHandle: (MemorySegment, MemorySegment, Boolean) -> Boolean by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("getBooleanByHandle").orElseThrow(),
+            FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, ADDRESS, JAVA_BOOLEAN)
+        )
+
+        return@lazy { mmkv, handle, default ->
+            funcHandle.invoke(mmkv, handle, default) as Boolean
+        }
+    }
+    val setBooleanByHandle: (MemorySegment, MemorySegment, Boolean) -> Boolean by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("setBooleanByHandle").orElseThrow(),
+            FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, ADDRESS, JAVA_BOOLEAN)
+        )
+
+        return@lazy { mmkv, handle, value ->
+            funcHandle.invoke(mmkv, handle, value) as Boolean
+        }
+    }
+
+    val getStringByHandle: (MemorySegment, MemorySegment, String) -> String by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("mmkv_readValueIntoByHandle").orElseThrow(),
+            FunctionDescriptor.of(JAVA_LONG, ADDRESS, ADDRESS, ADDRESS, JAVA_LONG)
+        )
+
+        return@lazy { mmkv, handle, default ->
+            readIntoScratch { funcHandle.invoke(mmkv, handle, it, it.byteSize()) as Long }
+                ?.toArray(JAVA_BYTE)?.decodeToString() ?: default
+        }
+    }
+    val setStringByHandle: (MemorySegment, MemorySegment, String) -> Boolean by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("setStringByHandle").orElseThrow(),
+            FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, ADDRESS, ADDRESS, JAVA_LONG)
+        )
+
+        return@lazy { mmkv, handle, value ->
+            val bytes = value.encodeToByteArray()
+            val cValue = NativeScratch.get(bytes.size.toLong())
+            MemorySegment.copy(bytes, 0, cValue, JAVA_BYTE, 0, bytes.size)
+            funcHandle.invoke(mmkv, handle, cValue, bytes.size.toLong()) as Boolean
+        }
+    }
+
+    val getByteArrayByHandle: (MemorySegment, MemorySegment, ByteArray?) -> ByteArray? by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("mmkv_readValueIntoByHandle").orElseThrow(),
+            FunctionDescriptor.of(JAVA_LONG, ADDRESS, ADDRESS, ADDRESS, JAVA_LONG)
+        )
+
+        return@lazy { mmkv, handle, default ->
+            readIntoScratch { funcHandle.invoke(mmkv, handle, it, it.byteSize()) as Long }
+                ?.toArray(JAVA_BYTE) ?: default
+        }
+    }
+    val setByteArrayByHandle: (MemorySegment, MemorySegment, ByteArray) -> Boolean by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("setByteArrayByHandle").orElseThrow(),
+            FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, ADDRESS, ADDRESS, JAVA_LONG)
+        )
+
+        return@lazy { mmkv, handle, value ->
+            val cValue = NativeScratch.get(value.size.toLong())
+            MemorySegment.copy(value, 0, cValue, JAVA_BYTE, 0, value.size)
+            funcHandle.invoke(mmkv, handle, cValue, value.size.toLong()) as Boolean
+        }
+    }
+
+    val removeValueByHandle: (MemorySegment, MemorySegment) -> Boolean by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("mmkv_removeValueByHandle").orElseThrow(),
+            FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, ADDRESS)
+        )
+
+        return@lazy { mmkv, handle ->
+            funcHandle.invoke(mmkv, handle) as Boolean
+        }
+    }
+
+    val containsKeyByHandle: (MemorySegment, MemorySegment) -> Boolean by lazy {
+        val funcHandle = Linker.nativeLinker().downcallHandle(
+            dll!!.find("mmkv_containsKeyByHandle").orElseThrow(),
+            FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, ADDRESS)
+        )
+
+        return@lazy { mmkv, handle ->
+            funcHandle.invoke(mmkv, handle) as Boolean
+        }
+    }
+
+    /**
+     * 将值读入线程私有的缓冲区，容量不足时扩容重读；[read] 返回值的字节长度，-1 表示 key 不存在
+     * @return 值所在的内存片段，key 不存在时返回 null
+     */
+    private inline fun readIntoScratch(read: (MemorySegment) -> Long): MemorySegment? {
+        var scratch = NativeScratch.get(0)
+        var size = read(scratch)
+        while (size > scratch.byteSize()) {
+            scratch = NativeScratch.get(size)
+            size = read(scratch)
+        }
+        return if (size < 0) null else scratch.asSlice(0, size)
+    }
+
+    // 仅部分平台的 native 库导出的函数，找不到时返回 null
+    private fun findOrNull(name: String): MemorySegment? = dll!!.find(name).orElse(null)
+
     private val free by lazy {
         val func = with(Linker.nativeLinker()) {
             downcallHandle(
@@ -0,0 +1,307 @@
+package com.ctrip.flight.mmkv
+
+import java.lang.foreign.Arena
+import java.lang.foreign.FunctionDescriptor
+import java.lang.foreign.Linker
+import java.lang.foreign.MemoryLayout
+import java.lang.foreign.MemorySegment
+import java.lang.foreign.ValueLayout
+import java.lang.foreign.ValueLayout.*
+import java.lang.invoke.MethodHandle
+
+/**
+ * 定长类型读写的快速路径：key 以 UTF-8 编码进线程私有的缓冲区并显式传入长度，整个调用不分配 Arena 与对象；
+ * MethodHandle 保存在静态 final 字段中以便 JIT 内联。读取可能等待 MMKV 的实例锁，不使用 critical 链接，
+ * 以免阻塞期间拖住整个 JVM 的 safepoint。native 库未提供对应函数时退回 [NativeMMKV]
+ */
+internal object NativePrimitives {
+
+    private const val INITIAL_KEY_BUFFER_SIZE = 256L
+
+    private val keyBuffers = ThreadLocal.withInitial { Arena.ofAuto().allocate(INITIAL_KEY_BUFFER_SIZE) }
+
+    private val getIntHandle = getter("mmkv_getInt", JAVA_INT)
+    private val setIntHandle = setter("mmkv_setInt", JAVA_INT)
+
+    private val getUIntHandle = getter("mmkv_getUInt", JAVA_INT)
+    private val setUIntHandle = setter("mmkv_setUInt", JAVA_INT)
+
+    private val getLongHandle = getter("mmkv_getLong", JAVA_LONG)
+    private val setLongHandle = setter("mmkv_setLong", JAVA_LONG)
+
+    private val getULongHandle = getter("mmkv_getULong", JAVA_LONG)
+    private val setULongHandle = setter("mmkv_setULong", JAVA_LONG)
+
+    private val getFloatHandle = getter("mmkv_getFloat", JAVA_FLOAT)
+    private val setFloatHandle = setter("mmkv_setFloat", JAVA_FLOAT)
+
+    private val getDoubleHandle = getter("mmkv_getDouble", JAVA_DOUBLE)
+    private val setDoubleHandle = setter("mmkv_setDouble", JAVA_DOUBLE)
+
+    private val getBooleanHandle = getter("mmkv_getBoolean", JAVA_BOOLEAN)
+    private val setBooleanHandle = setter("mmkv_setBoolean", JAVA_BOOLEAN)
+
+    private val addIntHandle = function("mmkv_addInt32", JAVA_INT, JAVA_INT, JAVA_INT)
+    private val addLongHandle = function("mmkv_addInt64", JAVA_LONG, JAVA_LONG, JAVA_LONG)
+    private val addLongMergedHandle = function("mmkv_addInt64Merged", null, JAVA_LONG)
+
+    private val compareAndSetIntHandle = compareAndSetter("mmkv_compareAndSetInt", JAVA_INT)
+    private val compareAndSetUIntHandle = compareAndSetter("mmkv_compareAndSetUInt", JAVA_INT)
+    private val compareAndSetLongHandle = compareAndSetter("mmkv_compareAndSetLong", JAVA_LONG)
+    private val compareAndSetULongHandle = compareAndSetter("mmkv_compareAndSetULong", JAVA_LONG)
+    private val compareAndSetFloatHandle = compareAndSetter("mmkv_compareAndSetFloat", JAVA_FLOAT)
+    private val compareAndSetDoubleHandle = compareAndSetter("mmkv_compareAndSetDouble", JAVA_DOUBLE)
+    private val compareAndSetBooleanHandle = compareAndSetter("mmkv_compareAndSetBoolean", JAVA_BOOLEAN)
+
+    fun getInt(mmkv: MemorySegment, key: String, default: Int): Int {
+        val handle = getIntHandle ?: return NativeMMKV.getInt(mmkv, key, default)
+        val cKey = keyBuffer(key)
+        val size = encodeKey(key, cKey)
+        return handle.invoke(mmkv, cKey, size, default) as Int
+    }
+
+    fun setInt(mmkv: MemorySegment, key: String, value: Int): Boolean {
+        val handle = setIntHandle ?: return NativeMMKV.setInt(mmkv, key, value)
+        val cKey = keyBuffer(key)
+        val size = encodeKey(key, cKey)
+        return handle.invoke(mmkv, cKey, size, value) as Boolean
+    }
+
+    fun getUInt(mmkv: MemorySegment, key: String, default: UInt): UInt {
+        val handle = getUIntHandle ?: return NativeMMKV.getUInt(mmkv, key, default)
+        val cKey = keyBuffer(key)
+        val size = encodeKey(key, cKey)
+        return (handle.invoke(mmkv, cKey, size, default.toInt()) as Int).toUInt()
+    }
+
+    fun setUInt(mmkv: MemorySegment, key: String, value: UInt): Boolean {
+        val handle = setUIntHandle ?: return NativeMMKV.setUInt(mmkv, key, value)
+        val cKey = keyBuffer(key)
+        val size = encodeKey(key, cKey)
+        return handle.invoke(mmkv, cKey, size, value.toInt()) as Boolean
+    }
+
+    fun getLong(mmkv: MemorySegment, key: String, default: Long): Long {
+        val handle = getLongHandle ?: return NativeMMKV.getLong(mmkv, key, default)
+        val cKey = keyBuffer(key)
+        val size = encodeKey(key, cKey)
+        return handle.invoke(mmkv, cKey, size, default) as Long
+    }
+
+    fun setLong(mmkv: MemorySegment, key: String, value: Long): Boolean {
+        val handle = setLongHandle ?: return NativeMMKV.setLong(mmkv, key, value)
+        val cKey = keyBuffer(key)
+        val size = encodeKey(key, cKey)
+        return handle.invoke(mmkv, cKey, size, value) as Boolean
+    }
+
+    fun getULong(mmkv: MemorySegment, key: String, default: ULong): ULong {
+        val handle = getULongHandle ?: return NativeMMKV.getULong(mmkv, key, default)
+        val cKey = keyBuffer(key)
+        val size = encodeKey(key, cKey)
+        return (handle.invoke(mmkv, cKey, size, default.toLong()) as Long).toULong()
+    }
+
+    fun setULong(mmkv: MemorySegment, key: String, value: ULong): Boolean {
+        val handle = setULongHandle ?: return NativeMMKV.setULong(mmkv, key, value)
+        val cKey = keyBuffer(key)
+        val size = encodeKey(key, cKey)
+        return handle.invoke(mmkv, cKey, size, value.toLong()) as Boolean
+    }
+
+    fun getFloat(mmkv: MemorySegment, key: String, default: Float): Float {
+        val handle = getFloatHandle ?: return NativeMMKV.getFloat(mmkv, key, default)
+        val cKey = keyBuffer(key)
+        val size = encodeKey(key, cKey)
+        return handle.invoke(mmkv, cKey, size, default) as Float
+    }
+
+    fun setFloat(mmkv: MemorySegment, key: String, value: Float): Boolean {
+        val handle = setFloatHandle ?: return NativeMMKV.setFloat(mmkv, key, value)
+        val cKey = keyBuffer(key)
+        val size = encodeKey(key, cKey)
+        return handle.invoke(mmkv, cKey, size, value) as Boolean
+    }
+
+    fun getDouble(mmkv: MemorySegment, key: String, default: Double): Double {
+        val handle = getDoubleHandle ?: return NativeMMKV.getDouble(mmkv, key, default)
+        val cKey = keyBuffer(key)
+        val size = encodeKey(key, cKey)
+        return handle.invoke(mmkv, cKey, size, default) as Double
+    }
+
+    fun setDouble(mmkv: MemorySegment, key: String, value: Double): Boolean {
+        val handle = setDoubleHandle ?: return NativeMMKV.setDouble(mmkv, key, value)
+        val cKey = keyBuffer(key)
+        val size = encodeKey(key, cKey)
+        return handle.invoke(mmkv, cKey, size, value) as Boolean
+    }
+
+    fun getBoolean(mmkv: MemorySegment, key: String, default: Boolean): Boolean {
+        val handle = getBooleanHandle ?: return NativeMMKV.getBoolean(mmkv, key, default)
+        val cKey = keyBuffer(key)
+        val size = encodeKey(key, cKey)
+        return handle.invoke(mmkv, cKey, size, default) as Boolean
+    }
+
+    fun setBoolean(mmkv: MemorySegment, key: String, value: Boolean): Boolean {
+        val handle = setBooleanHandle ?: return NativeMMKV.setBoolean(mmkv, key, value)
+        val cKey = keyBuffer(key)
+        val size = encodeKey(key, cKey)
+        return handle.invoke(mmkv, cKey, size, value) as Boolean
+    }
+
+    fun addInt(mmkv: MemorySegment, key: String, delta: Int, default: Int): Int {
+        val handle = addIntHandle ?: unsupported("mmkv_addInt32")
+        val cKey = keyBuffer(key)
+        val size = encodeKey(key, cKey)
+        return handle.invoke(mmkv, cKey, size, delta, default) as Int
+    }
+
+    fun addLong(mmkv: MemorySegment, key: String, delta: Long, default: Long): Long {
+        val handle = addLongHandle ?: unsupported("mmkv_addInt64")
+        val cKey = keyBuffer(key)
+        val size = encodeKey(key, cKey)
+        return handle.invoke(mmkv, cKey, size, delta, default) as Long
+    }
+
+    fun addLongMerged(mmkv: MemorySegment, key: String, delta: Long) {
+        val handle = addLongMergedHandle ?: unsupported("mmkv_addInt64Merged")
+        val cKey = keyBuffer(key)
+        val size = encodeKey(key, cKey)
+        handle.invoke(mmkv, cKey, size, delta)
+    }
+
+    fun compareAndSetInt(mmkv: MemorySegment, key: String, expected: Int, value: Int): Boolean {
+        return compareAndSet(compareAndSetIntHandle, "mmkv_compareAndSetInt", mmkv, key, expected, value)
+    }
+
+    fun compareAndSetUInt(mmkv: MemorySegment, key: String, expected: UInt, value: UInt): Boolean {
+        return compareAndSet(compareAndSetUIntHandle, "mmkv_compareAndSetUInt", mmkv, key, expected.toInt(), value.toInt())
+    }
+
+    fun compareAndSetLong(mmkv: MemorySegment, key: String, expected: Long, value: Long): Boolean {
+        return compareAndSet(compareAndSetLongHandle, "mmkv_compareAndSetLong", mmkv, key, expected, value)
+    }
+
+    fun compareAndSetULong(mmkv: MemorySegment, key: String, expected: ULong, value: ULong): Boolean {
+        return compareAndSet(
+            compareAndSetULongHandle, "mmkv_compareAndSetULong", mmkv, key, expected.toLong(), value.toLong()
+        )
+    }
+
+    fun compareAndSetFloat(mmkv: MemorySegment, key: String, expected: Float, value: Float): Boolean {
+        return compareAndSet(compareAndSetFloatHandle, "mmkv_compareAndSetFloat", mmkv, key, expected, value)
+    }
+
+    fun compareAndSetDouble(mmkv: MemorySegment, key: String, expected: Double, value: Double): Boolean {
+        return compareAndSet(compareAndSetDoubleHandle, "mmkv_compareAndSetDouble", mmkv, key, expected, value)
+    }
+
+    fun compareAndSetBoolean(mmkv: MemorySegment, key: String, expected: Boolean, value: Boolean): Boolean {
+        return compareAndSet(compareAndSetBooleanHandle, "mmkv_compareAndSetBoolean", mmkv, key, expected, value)
+    }
+
+    private fun compareAndSet(
+        handle: MethodHandle?,
+        name: String,
+        mmkv: MemorySegment,
+        key: String,
+        expected: Any,
+        value: Any,
+    ): Boolean {
+        val cKey = keyBuffer(key)
+        val size = encodeKey(key, cKey)
+        return (handle ?: unsupported(name)).invoke(mmkv, cKey, size, expected, value) as Boolean
+    }
+
+    private fun unsupported(name: String): Nothing {
+        throw UnsupportedOperationException("$name is not available in this native library")
+    }
+
+    private fun getter(name: String, layout: ValueLayout): MethodHandle? {
+        val symbol = NativeMMKV.dll!!.find(name).orElse(null) ?: return null
+        return Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(layout, ADDRESS, ADDRESS, JAVA_LONG, layout)
+        )
+    }
+
+    private fun setter(name: String, layout: ValueLayout): MethodHandle? {
+        val symbol = NativeMMKV.dll!!.find(name).orElse(null) ?: return null
+        return Linker.nativeLinker().downcallHandle(
+            symbol,
+            FunctionDescriptor.of(JAVA_BOOLEAN, ADDRESS, ADDRESS, JAVA_LONG, layout)
+        )
+    }
+
+    // (mmkv, key, keySize, args...)，result 为 null 时无返回值
+    private fun function(name: String, result: ValueLayout?, vararg args: ValueLayout): MethodHandle? {
+        val symbol = NativeMMKV.dll!!.find(name).orElse(null) ?: return null
+        val layouts = arrayOf<MemoryLayout>(ADDRESS, ADDRESS, JAVA_LONG, *args)
+        val descriptor = if (result != null) {
+            FunctionDescriptor.of(result, *layouts)
+        } else {
+            FunctionDescriptor.ofVoid(*layouts)
+        }
+        return Linker.nativeLinker().downcallHandle(symbol, descriptor)
+    }
+
+    private fun compareAndSetter(name: String, layout: ValueLayout): MethodHandle? {
+        return function(name, JAVA_BOOLEAN, layout, layout)
+    }
+
+    // UTF-8 最多 3 字节对应一个 char（代理对 4 字节对应两个 char）
+    private fun keyBuffer(key: String): MemorySegment {
+        val buffer = keyBuffers.get()
+        val required = key.length * 3L
+        if (buffer.byteSize() >= required) {
+            return buffer
+        }
+        val grown = Arena.ofAuto().allocate(maxOf(required, buffer.byteSize() * 2))
+        keyBuffers.set(grown)
+        return grown
+    }
+
+    /**
+     * 将 key 以 UTF-8 写入 [segment]，返回写入的字节数；孤立的代理字符与 [String.encodeToByteArray] 一样编码为 U+FFFD
+     */
+    private fun encodeKey(key: String, segment: MemorySegment): Long {
+        var position = 0L
+        var index = 0
+        while (index < key.length) {
+            val char = key[index]
+            val code = char.code
+            when {
+                code < 0x80 -> {
+                    segment.set(JAVA_BYTE, position++, code.toByte())
+                }
+                code < 0x800 -> {
+                    segment.set(JAVA_BYTE, position++, (0xC0 or (code shr 6)).toByte())
+                    segment.set(JAVA_BYTE, position++, (0x80 or (code and 0x3F)).toByte())
+                }
+                char.isSurrogate() -> {
+                    if (char.isHighSurrogate() && index + 1 < key.length && key[index + 1].isLowSurrogate()) {
+                        val codePoint = Character.toCodePoint(char, key[index + 1])
+                        segment.set(JAVA_BYTE, position++, (0xF0 or (codePoint shr 18)).toByte())
+                        segment.set(JAVA_BYTE, position++, (0x80 or ((codePoint shr 12) and 0x3F)).toByte())
+                        segment.set(JAVA_BYTE, position++, (0x80 or ((codePoint shr 6) and 0x3F)).toByte())
+                        segment.set(JAVA_BYTE, position++, (0x80 or (codePoint and 0x3F)).toByte())
+                        index++
+                    } else {
+                        segment.set(JAVA_BYTE, position++, 0xEF.toByte())
+                        segment.set(JAVA_BYTE, position++, 0xBF.toByte())
+                        segment.set(JAVA_BYTE, position++, 0xBD.toByte())
+                    }
+                }
+                else -> {
+                    segment.set(JAVA_BYTE, position++, (0xE0 or (code shr 12)).toByte())
+                    segment.set(JAVA_BYTE, position++, (0x80 or ((code shr 6) and 0x3F)).toByte())
+                    segment.set(JAVA_BYTE, position++, (0x80 or (code and 0x3F)).toByte())
+                }
+            }
+            index++
+        }
+        return position
+    }
+}
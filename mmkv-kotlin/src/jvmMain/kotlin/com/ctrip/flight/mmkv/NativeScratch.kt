@@ -0,0 +1,32 @@
+package com.ctrip.flight.mmkv
+
+import java.lang.foreign.Arena
+import java.lang.foreign.MemorySegment
+
+/**
+ * 线程私有的可复用堆外内存，用于在 downcall 前后中转数据，避免每次调用都分配
+ */
+internal object NativeScratch {
+    private const val INITIAL_SIZE = 4096L
+
+    // 每个线程常驻的上限，更大的值每次单独分配，由 GC 回收，避免读过一次大值后一直占用
+    private const val MAX_RETAINED_SIZE = 64 * 1024L
+
+    private val local = ThreadLocal.withInitial { Arena.ofAuto().allocate(INITIAL_SIZE, 8) }
+
+    /**
+     * 返回至少 [minSize] 字节的内存，内容不保证清零；不超过常驻上限时同一线程上一次返回的内存会被复用
+     */
+    fun get(minSize: Long): MemorySegment {
+        val current = local.get()
+        if (current.byteSize() >= minSize) {
+            return current
+        }
+        if (minSize > MAX_RETAINED_SIZE) {
+            return Arena.ofAuto().allocate(minSize, 8)
+        }
+        val grown = Arena.ofAuto().allocate(minOf(maxOf(minSize, current.byteSize() * 2), MAX_RETAINED_SIZE), 8)
+        local.set(grown)
+        return grown
+    }
+}
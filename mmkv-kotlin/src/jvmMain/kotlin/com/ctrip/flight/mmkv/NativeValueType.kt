@@ -0,0 +1,35 @@
+package com.ctrip.flight.mmkv
+
+/**
+ * 批量接口中值的类型标记，顺序需与 native 侧 NativeValueType 保持一致
+ */
+internal enum class NativeValueType {
+    BOOLEAN,
+    INT,
+    UINT,
+    LONG,
+    ULONG,
+    FLOAT,
+    DOUBLE,
+    STRING,
+    BYTE_ARRAY,
+    REMOVE;
+
+    val tag: Int
+        get() = ordinal
+
+    companion object {
+        fun of(value: Any): NativeValueType = when (value) {
+            is Boolean -> BOOLEAN
+            is Int -> INT
+            is UInt -> UINT
+            is Long -> LONG
+            is ULong -> ULONG
+            is Float -> FLOAT
+            is Double -> DOUBLE
+            is String -> STRING
+            is ByteArray -> BYTE_ARRAY
+            else -> throw IllegalArgumentException("Unsupported value type ${value::class}")
+        }
+    }
+}
@@ -0,0 +1,59 @@
+package com.ctrip.flight.mmkv
+
+import java.lang.foreign.Arena
+import java.lang.foreign.MemorySegment
+import java.lang.foreign.ValueLayout.JAVA_BYTE
+import java.lang.foreign.ValueLayout.JAVA_LONG
+
+/**
+ * 紧凑的字符串列表，布局需与 native 侧保持一致：
+ * count(u64) | offsets(u64 × (count + 1)) | 字节数据，第 i 个字符串为数据区中的 [offsets[i], offsets[i + 1])
+ */
+internal object PackedStringList {
+
+    private fun headerSize(count: Long): Long = JAVA_LONG.byteSize() * (count + 2)
+
+    /**
+     * 在 [arena] 中一次分配并写入整个列表
+     */
+    fun encode(arena: Arena, strings: Collection<String>): MemorySegment {
+        val encoded = strings.map { it.encodeToByteArray() }
+        val headerSize = headerSize(encoded.size.toLong())
+        val segment = arena.allocate(headerSize + encoded.sumOf { it.size.toLong() }, 8)
+        segment.setAtIndex(JAVA_LONG, 0, encoded.size.toLong())
+        var offset = 0L
+        encoded.forEachIndexed { index, bytes ->
+            segment.setAtIndex(JAVA_LONG, index + 1L, offset)
+            MemorySegment.copy(bytes, 0, segment, JAVA_BYTE, headerSize + offset, bytes.size)
+            offset += bytes.size
+        }
+        segment.setAtIndex(JAVA_LONG, encoded.size + 1L, offset)
+        return segment
+    }
+
+    /**
+     * 一次拷贝出数据区后逐个解码，[segment] 需至少覆盖整个列表，其后可以有额外数据
+     */
+    fun <C : MutableCollection<String>> decode(segment: MemorySegment, destination: C): C {
+        val count = segment.getAtIndex(JAVA_LONG, 0)
+        val headerSize = headerSize(count)
+        val data = segment.asSlice(headerSize, dataSize(segment, count)).toArray(JAVA_BYTE)
+        var begin = segment.getAtIndex(JAVA_LONG, 1).toInt()
+        for (i in 0 until count) {
+            val end = segment.getAtIndex(JAVA_LONG, i + 2).toInt()
+            destination.add(data.decodeToString(begin, end))
+            begin = end
+        }
+        return destination
+    }
+
+    /**
+     * 列表之后附加数据（8 字节对齐）的起始偏移
+     */
+    fun trailerOffset(segment: MemorySegment): Long {
+        val count = segment.getAtIndex(JAVA_LONG, 0)
+        return alignTo8(headerSize(count) + dataSize(segment, count))
+    }
+
+    private fun dataSize(segment: MemorySegment, count: Long): Long = segment.getAtIndex(JAVA_LONG, count + 1)
+}
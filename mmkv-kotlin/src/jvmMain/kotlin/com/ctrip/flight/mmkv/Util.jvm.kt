@@ -29,6 +29,37 @@ actual fun unregisterHandler() {
     NativeMMKV.unregisterHandler()
 }
 
+/**
+ * Cap the memory held by all open instances together. Once the estimated resident memory exceeds
+ * [budgetBytes], a background native thread releases the mapping and decoded values of the least
+ * recently used instances that have not been accessed for [idleMillis]. A released instance stays
+ * usable and is reloaded on its next access. 0 turns the budget off
+ */
+fun setMemoryBudget(budgetBytes: Long, idleMillis: Long = 10_000) {
+    require(budgetBytes >= 0) { "budgetBytes must not be negative" }
+    require(idleMillis >= 0) { "idleMillis must not be negative" }
+    val setBudget = NativeMMKV.setMemoryBudget
+        ?: throw UnsupportedOperationException("mmkv_setMemoryBudget is not available in this native library")
+    setBudget(budgetBytes, idleMillis)
+}
+
+/**
+ * Check the budget set by [setMemoryBudget] now instead of waiting for the background thread
+ * @return the number of instances released
+ */
+fun enforceMemoryBudget(): Long {
+    return NativeMMKV.enforceMemoryBudget?.invoke() ?: 0
+}
+
+/**
+ * Current state of the memory budget, see [MMKVMemoryBudgetState]
+ */
+fun memoryBudgetState(): MMKVMemoryBudgetState {
+    val state = NativeMMKV.memoryBudgetState
+        ?: throw UnsupportedOperationException("mmkv_memoryBudgetState is not available in this native library")
+    return state()
+}
+
 internal fun <T> useArena(arena: Arena = Arena.ofConfined(), block: Arena.() -> T): T =
     with(arena) {
         use(block)
@@ -0,0 +1,252 @@
+package com.ctrip.flight.mmkv
+
+import java.io.File
+import java.lang.management.ManagementFactory
+import kotlin.test.BeforeTest
+import kotlin.test.Test
+import kotlin.test.assertTrue
+
+/**
+ * JVM 侧性能对比，默认跳过，设置环境变量 MMKV_BENCH 后执行，例如：
+ * MMKV_BENCH=1 ./gradlew :mmkv-kotlin:jvmTest --tests "*MMKVBenchmark*"
+ */
+class MMKVBenchmark {
+
+    private val enabled = System.getenv("MMKV_BENCH") != null
+
+    private lateinit var mmkv: MMKV_KMP
+
+    @BeforeTest
+    fun setup() {
+        if (!enabled) return
+        if (!NativeMMKV.isInitialized) {
+            initialize(
+                File(System.getProperty("user.home")).resolve(".cache").resolve("mmkv-test").absolutePath,
+                MMKVLogLevel.LevelNone,
+            )
+        }
+        mmkv = mmkvWithID("mmkv-benchmark")
+    }
+
+    // 批量写入与逐个写入对比
+    @Test
+    fun benchmarkSetAll() {
+        if (!enabled) return
+        for (size in listOf(50, 100, 500)) {
+            val values = (0 until size).associate { index ->
+                "bench_$index" to when (index % 4) {
+                    0 -> index
+                    1 -> index.toLong()
+                    2 -> "value_$index"
+                    else -> index % 2 == 0
+                }
+            }
+            measure("set loop, $size keys") {
+                values.forEach { (key, value) ->
+                    when (value) {
+                        is Int -> mmkv[key] = value
+                        is Long -> mmkv[key] = value
+                        is String -> mmkv[key] = value
+                        is Boolean -> mmkv[key] = value
+                    }
+                }
+            }
+            measure("setAll, $size keys") {
+                mmkv.setAll(values)
+            }
+            mmkv.clearAll()
+        }
+    }
+
+    // 批量读取与逐个读取对比
+    @Test
+    fun benchmarkGetAll() {
+        if (!enabled) return
+        for (size in listOf(50, 100, 500)) {
+            val defaults = (0 until size).associate { index ->
+                "bench_$index" to if (index % 2 == 0) 0 else ""
+            }
+            mmkv.setAll(defaults.mapValues { (key, default) -> if (default is Int) key.length else key })
+            measure("get loop, $size keys") {
+                defaults.forEach { (key, default) ->
+                    if (default is Int) mmkv.getInt(key, default) else mmkv.getString(key, default as String)
+                }
+            }
+            measure("getAll, $size keys") {
+                mmkv.getAll(defaults)
+            }
+            mmkv.clearAll()
+        }
+    }
+
+    // 大字节数组读取：复制到新数组与读入可复用缓冲区对比
+    @Test
+    fun benchmarkByteArrayIntoBuffer() {
+        if (!enabled) return
+        for (size in listOf(64 * 1024, 512 * 1024, 2 * 1024 * 1024)) {
+            val key = "bench_blob_$size"
+            mmkv[key] = ByteArray(size) { it.toByte() }
+            val buffer = ByteArray(size)
+            measure("getByteArray, $size bytes") {
+                mmkv.getByteArray(key)
+            }
+            measure("getByteArray into buffer, $size bytes") {
+                mmkv.getByteArray(key, buffer, 0)
+            }
+            mmkv.removeValueForKey(key)
+        }
+    }
+
+    // 字符串读取：'\0' 结尾 + free 的旧路径与显式长度的新路径对比
+    @Test
+    fun benchmarkGetString() {
+        if (!enabled) return
+        val ptr = (mmkv as MMKVImpl).ptr
+        for (size in listOf(8, 64, 1024, 16 * 1024, 256 * 1024)) {
+            val key = "bench_string_$size"
+            mmkv[key] = "s".repeat(size)
+            measure("getString (NUL-terminated), $size chars", iterations = 10_000) {
+                NativeMMKV.getCString(ptr, key, "")
+            }
+            measure("getString (length-prefixed), $size chars", iterations = 10_000) {
+                NativeMMKV.getString(ptr, key, "")
+            }
+            mmkv.removeValueForKey(key)
+        }
+    }
+
+    // String key 与预注册的 MMKVKey 对比
+    @Test
+    fun benchmarkMMKVKey() {
+        if (!enabled) return
+        val impl = mmkv as MMKVImpl
+        val names = List(200) { "bench_hot_key_$it" }
+        val keys = names.map { MMKVKey(it) }
+        names.forEachIndexed { index, name -> mmkv[name] = index }
+        measure("getInt by String, ${names.size} keys", iterations = 5_000) {
+            names.forEach { mmkv.getInt(it) }
+        }
+        measure("getInt by MMKVKey, ${keys.size} keys", iterations = 5_000) {
+            keys.forEach { impl.getInt(it) }
+        }
+        measure("setInt by String, ${names.size} keys", iterations = 1_000) {
+            names.forEach { mmkv[it] = 1 }
+        }
+        measure("setInt by MMKVKey, ${keys.size} keys", iterations = 1_000) {
+            keys.forEach { impl[it] = 1 }
+        }
+        mmkv.clearAll()
+    }
+
+    // 全量 allKeys 后过滤与按前缀分批遍历对比
+    @Test
+    fun benchmarkKeyIteration() {
+        if (!enabled) return
+        val keys = (0 until 100_000).associate { "user:${it % 100}:$it" to it }
+        mmkv.setAll(keys)
+        measure("allKeys + filter, ${keys.size} keys", iterations = 20) {
+            mmkv.allKeys().count { it.startsWith("user:42:") }
+        }
+        measure("keys(prefix), ${keys.size} keys", iterations = 20) {
+            mmkv.keys("user:42:").count()
+        }
+        measure("keys(), ${keys.size} keys", iterations = 20) {
+            mmkv.keys().count()
+        }
+        mmkv.clearAll()
+    }
+
+    // 同步写入与写后模式对比，写后模式包含最后一次 flush
+    @Test
+    fun benchmarkWriteBehind() {
+        if (!enabled) return
+        val impl = mmkv as MMKVImpl
+        val keys = List(100) { "bench_wb_$it" }
+        measure("set sync, ${keys.size} keys x 10", iterations = 200) {
+            repeat(10) { round -> keys.forEach { mmkv[it] = round } }
+        }
+        impl.enableWriteBehind()
+        measure("set write-behind, ${keys.size} keys x 10", iterations = 200) {
+            repeat(10) { round -> keys.forEach { mmkv[it] = round } }
+            impl.flush()
+        }
+        impl.enableWriteBehind(false)
+        mmkv.clearAll()
+    }
+
+    // 计数器：getLong + setLong、原生累加与合并计数对比，合并计数包含最后一次写入
+    @Test
+    fun benchmarkCounter() {
+        if (!enabled) return
+        val impl = mmkv as MMKVImpl
+        val key = "bench_counter"
+        measure("counter get+set x 1000", iterations = 100) {
+            repeat(1000) { mmkv[key] = mmkv.getLong(key) + 1 }
+        }
+        measure("counter addAndGet x 1000", iterations = 100) {
+            repeat(1000) { impl.addAndGet(key, 1L) }
+        }
+        impl.enableMergedCounters()
+        measure("counter addMerged x 1000", iterations = 100) {
+            repeat(1000) { impl.addMerged(key, 1L) }
+            impl.getLong(key)
+        }
+        impl.enableMergedCounters(false)
+        mmkv.removeValueForKey(key)
+    }
+
+    // 多线程写入单个实例与分片实例
+    @Test
+    fun benchmarkShardedWrites() {
+        if (!enabled) return
+        val threads = Runtime.getRuntime().availableProcessors().coerceAtMost(8)
+        val single = mmkvWithID("bench_sharded_single")
+        val sharded = shardedMMKV("bench_sharded", shardCount = threads)
+        for ((name, store) in listOf("single instance" to single, "$threads shards" to sharded)) {
+            measure("$name, $threads threads x 1000 set", iterations = 20) {
+                (0 until threads).map { thread ->
+                    Thread.ofPlatform().start {
+                        repeat(1000) { store["bench_$thread-$it"] = it }
+                    }
+                }.forEach { it.join() }
+            }
+            store.clearAll()
+            store.close()
+        }
+    }
+
+    // 预热后定长类型读写每次调用在 JVM 堆上分配的字节数，期望为 0
+    @Test
+    fun benchmarkPrimitiveAllocation() {
+        if (!enabled) return
+        val threadBean = ManagementFactory.getThreadMXBean() as com.sun.management.ThreadMXBean
+        val key = "bench_alloc_key"
+        mmkv[key] = 1L
+        val iterations = 1_000_000
+        var sum = 0L
+        repeat(iterations) { sum += mmkv.getLong(key) }
+
+        val before = threadBean.currentThreadAllocatedBytes
+        val start = System.nanoTime()
+        repeat(iterations) { sum += mmkv.getLong(key) }
+        val elapsed = System.nanoTime() - start
+        val allocated = threadBean.currentThreadAllocatedBytes - before
+        println("[MMKVBenchmark] getLong: ${elapsed / iterations} ns/op, ${allocated.toDouble() / iterations} B/op ($sum)")
+        assertTrue(allocated < iterations, "warm getLong should not allocate, got $allocated bytes")
+
+        repeat(iterations / 10) { mmkv[key] = it.toLong() }
+        val beforeSet = threadBean.currentThreadAllocatedBytes
+        repeat(iterations / 10) { mmkv[key] = it.toLong() }
+        val allocatedSet = threadBean.currentThreadAllocatedBytes - beforeSet
+        println("[MMKVBenchmark] setLong: ${allocatedSet.toDouble() / (iterations / 10)} B/op")
+        mmkv.removeValueForKey(key)
+    }
+
+    private inline fun measure(name: String, iterations: Int = 200, block: () -> Unit) {
+        repeat(iterations / 10) { block() }
+        val start = System.nanoTime()
+        repeat(iterations) { block() }
+        val elapsed = System.nanoTime() - start
+        println("[MMKVBenchmark] $name: ${elapsed / iterations / 1000} us/op")
+    }
+}
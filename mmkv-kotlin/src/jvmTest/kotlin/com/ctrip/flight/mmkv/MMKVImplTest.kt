@@ -1,10 +1,17 @@
 package com.ctrip.flight.mmkv
 
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.cancelAndJoin
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.flow.toList
 import kotlinx.coroutines.joinAll
 import kotlinx.coroutines.launch
 import kotlinx.coroutines.runBlocking
+import kotlinx.coroutines.withTimeout
+import kotlinx.coroutines.withTimeoutOrNull
 import java.io.File
+import java.lang.foreign.Arena
+import java.lang.foreign.ValueLayout
 import java.util.concurrent.CountDownLatch
 import java.util.concurrent.Executors
 import java.util.concurrent.TimeUnit
@@ -55,6 +62,28 @@ class MMKVImplTest {
         assertEquals("", mmkv.takeString(key, ""))
     }
 
+    // 字符串内嵌 '\u0000' 与超过默认缓冲区长度的字符串
+    @Test
+    fun testStringWithLength() {
+        val key = "stringWithNulKey"
+        val value = "head\u0000middle\u0000tail"
+        assertTrue(mmkv.set(key, value))
+        assertEquals(value, mmkv.getString(key))
+
+        val longValue = "长字符串".repeat(4096)
+        assertTrue(mmkv.set(key, longValue))
+        assertEquals(longValue, mmkv.getString(key))
+
+        // 定长类型的值按字符串读取时返回默认值
+        mmkv["intValueKey"] = 123_456
+        assertEquals("default", mmkv.getString("intValueKey", "default"))
+        mmkv["longValueKey"] = Long.MAX_VALUE
+        assertEquals("default", mmkv.getString("longValueKey", "default"))
+
+        assertTrue(mmkv.set(key, ""))
+        assertEquals("", mmkv.getString(key, "default"))
+    }
+
     // 布尔值测试
     @Test
     fun testBooleanOperations() {
@@ -87,6 +116,18 @@ class MMKVImplTest {
         assertEquals(Int.MIN_VALUE, mmkv.takeInt(key, 0))
     }
 
+    // 非 ASCII 与代理对 key 走快速路径后仍与 String key 的其他接口一致
+    @Test
+    fun testPrimitiveWithUnicodeKey() {
+        val keys = listOf("ascii", "中文键", "emoji😀键", "é")
+        keys.forEachIndexed { index, key ->
+            assertTrue(mmkv.set(key, index))
+            assertEquals(index, mmkv.getInt(key))
+            assertTrue(mmkv.containsKey(key))
+        }
+        assertTrue(mmkv.allKeys().containsAll(keys))
+    }
+
     // 长整型测试
     @Test
     fun testLongOperations() {
@@ -157,6 +198,37 @@ class MMKVImplTest {
         assertContentEquals(defaultArray, mmkv.takeByteArray("nonExistentKey", defaultArray))
     }
 
+    // 读取字节数组到可复用缓冲区测试
+    @Test
+    fun testByteArrayIntoBuffer() {
+        val key = "blobKey"
+        val value = ByteArray(64 * 1024) { it.toByte() }
+        assertTrue(mmkv.set(key, value))
+
+        // 缓冲区足够
+        val buffer = ByteArray(value.size + 16)
+        assertEquals(value.size, mmkv.getByteArray(key, buffer, 16))
+        assertContentEquals(value, buffer.copyOfRange(16, buffer.size))
+
+        // 缓冲区不足时只返回大小
+        val small = ByteArray(16)
+        assertEquals(value.size, mmkv.getByteArray(key, small, 0))
+        assertContentEquals(ByteArray(16), small)
+
+        // offset 超出缓冲区时同样只返回大小
+        assertEquals(value.size, mmkv.getByteArray(key, small, small.size + 1))
+
+        // 不存在的键
+        assertEquals(-1, mmkv.getByteArray("nonExistentKey", buffer, 0))
+
+        // 堆外内存
+        Arena.ofConfined().use { arena ->
+            val segment = arena.allocate(value.size.toLong())
+            assertEquals(value.size.toLong(), (mmkv as MMKVImpl).getByteArray(key, segment))
+            assertContentEquals(value, segment.toArray(ValueLayout.JAVA_BYTE))
+        }
+    }
+
     // 无符号整型测试
     @Test
     fun testUIntOperations() {
@@ -214,6 +286,131 @@ class MMKVImplTest {
         assertNull(mmkv.takeStringSet(key, null))
     }
 
+    // 紧凑格式的字符串列表测试：包含空串、多字节字符以及大量 key
+    @Test
+    fun testPackedStringList() {
+        mmkv.clearAll()
+        val value = setOf("", "ascii", "中文", "emoji😀", "tab\tand\nnewline")
+        assertTrue(mmkv.set("packedSet", value))
+        assertEquals(value, mmkv.takeStringSet("packedSet", null))
+
+        val keys = (0 until 1000).map { "packed_key_$it" }
+        keys.forEach { mmkv[it] = it.length }
+        val allKeys = mmkv.allKeys()
+        assertEquals(keys.size + 1, allKeys.size)
+        assertTrue(allKeys.containsAll(keys))
+
+        mmkv.removeValuesForKeys(keys)
+        assertEquals(listOf("packedSet"), mmkv.allKeys())
+        mmkv.removeValuesForKeys(emptyList())
+        assertTrue(mmkv.containsKey("packedSet"))
+    }
+
+    // 批量写入测试
+    @Test
+    fun testSetAll() {
+        mmkv["batchRemoveKey"] = "toBeRemoved"
+        val values = mapOf(
+            "batchString" to "批量字符串",
+            "batchBoolean" to true,
+            "batchInt" to Int.MIN_VALUE,
+            "batchLong" to Long.MAX_VALUE,
+            "batchFloat" to 3.14159f,
+            "batchDouble" to 2.718281828459045,
+            "batchByteArray" to byteArrayOf(-1, 2, -3, 4, -5),
+            "batchUInt" to UInt.MAX_VALUE,
+            "batchULong" to ULong.MAX_VALUE,
+            "batchRemoveKey" to null,
+        )
+
+        assertTrue(mmkv.setAll(values))
+
+        assertEquals("批量字符串", mmkv.getString("batchString"))
+        assertTrue(mmkv.getBoolean("batchBoolean"))
+        assertEquals(Int.MIN_VALUE, mmkv.getInt("batchInt"))
+        assertEquals(Long.MAX_VALUE, mmkv.getLong("batchLong"))
+        assertEquals(3.14159f, mmkv.getFloat("batchFloat"))
+        assertEquals(2.718281828459045, mmkv.getDouble("batchDouble"))
+        assertContentEquals(byteArrayOf(-1, 2, -3, 4, -5), mmkv.getByteArray("batchByteArray"))
+        assertEquals(UInt.MAX_VALUE, mmkv.getUInt("batchUInt"))
+        assertEquals(ULong.MAX_VALUE, mmkv.getULong("batchULong"))
+        assertFalse(mmkv.containsKey("batchRemoveKey"))
+
+        // 删除不存在的 key 也算成功，与逐个写入的默认实现一致
+        assertTrue(mmkv.setAll(mapOf("batchAbsentKey" to null, "batchInt" to 1)))
+        assertFalse(mmkv.containsKey("batchAbsentKey"))
+        assertEquals(1, mmkv.getInt("batchInt"))
+
+        // 空 Map 与非法类型
+        assertTrue(mmkv.setAll(emptyMap()))
+        assertFailsWith<IllegalArgumentException> {
+            mmkv.setAll(mapOf("batchInvalid" to listOf(1)))
+        }
+    }
+
+    // 批量读取测试
+    @Test
+    fun testGetAll() {
+        val longValue = "长".repeat(100)
+        mmkv["batchString"] = longValue
+        mmkv["batchEmptyString"] = ""
+        mmkv["batchInt"] = -42
+        mmkv["batchFloat"] = 1.5f
+        mmkv["batchULong"] = ULong.MAX_VALUE
+        mmkv["batchByteArray"] = byteArrayOf(1, 0, -1)
+
+        val result = mmkv.getAll(
+            mapOf(
+                "batchString" to "",
+                "batchEmptyString" to "default",
+                "batchInt" to 0,
+                "batchFloat" to 0f,
+                "batchULong" to 0uL,
+                "batchByteArray" to byteArrayOf(),
+                "batchMissingLong" to 7L,
+                "batchMissingBoolean" to true,
+            )
+        )
+
+        assertEquals(longValue, result["batchString"])
+        assertEquals("", result["batchEmptyString"])
+        assertEquals(-42, result["batchInt"])
+        assertEquals(1.5f, result["batchFloat"])
+        assertEquals(ULong.MAX_VALUE, result["batchULong"])
+        assertContentEquals(byteArrayOf(1, 0, -1), result["batchByteArray"] as ByteArray)
+        assertEquals(7L, result["batchMissingLong"])
+        assertEquals(true, result["batchMissingBoolean"])
+        assertTrue(mmkv.getAll(emptyMap()).isEmpty())
+    }
+
+    // 预注册 key 测试
+    @Test
+    fun testMMKVKey() {
+        val impl = mmkv as MMKVImpl
+        val intKey = MMKVKey("handleInt")
+        val stringKey = MMKVKey("handleString")
+        val bytesKey = MMKVKey("handleBytes")
+
+        assertEquals(7, impl.getInt(intKey, 7))
+        assertTrue(impl.set(intKey, 42))
+        assertEquals(42, impl.getInt(intKey))
+        assertEquals(42, mmkv.getInt("handleInt"))
+
+        assertTrue(impl.set(stringKey, "句柄\u0000字符串"))
+        assertEquals("句柄\u0000字符串", impl.getString(stringKey))
+
+        assertTrue(impl.set(bytesKey, byteArrayOf(3, 2, 1)))
+        assertContentEquals(byteArrayOf(3, 2, 1), impl.getByteArray(bytesKey))
+
+        assertTrue(impl.set(MMKVKey("handleULong"), ULong.MAX_VALUE))
+        assertEquals(ULong.MAX_VALUE, impl.getULong(MMKVKey("handleULong")))
+
+        assertTrue(impl.containsKey(intKey))
+        impl.removeValueForKey(intKey)
+        assertFalse(impl.containsKey(intKey))
+        assertEquals(MMKVKey("handleInt"), intKey)
+    }
+
     // 移除多个键测试
     @Test
     fun testRemoveValuesForKeys() {
@@ -262,6 +459,102 @@ class MMKVImplTest {
         assertFalse(updatedKeys.contains("key2"))
     }
 
+    // 按前缀分批遍历键测试
+    @Test
+    fun testKeyIteration() = runBlocking {
+        mmkv.clearAll()
+        val userKeys = (0 until 1000).map { "user:$it:name" }
+        userKeys.forEach { mmkv[it] = it }
+        mmkv["order:1"] = 1
+        mmkv["用户:1"] = 1
+
+        // 批大小小于、等于、大于总数
+        for (batchSize in listOf(1, 7, 1000, 4096)) {
+            assertEquals(userKeys.toSet(), mmkv.keys("user:", batchSize).toSet())
+        }
+        assertEquals(1002, mmkv.keys().count())
+        assertEquals(listOf("用户:1"), mmkv.keys("用户").toList())
+        assertTrue(mmkv.keys("none:").none())
+        assertEquals(userKeys.toSet(), mmkv.keysFlow("user:", 64).toList().toSet())
+
+        // 只取一部分后丢弃序列，游标之后由 Cleaner 释放
+        assertEquals(10, mmkv.keys("user:", 3).take(10).count())
+        assertFailsWith<IllegalArgumentException> { mmkv.keys("user:", 0) }
+
+        // 带值大小的遍历，遍历中删除的键大小为 -1
+        val impl = mmkv as MMKVImpl
+        val entries = impl.keyEntries("user:1:").toList()
+        assertEquals(listOf(MMKVKeyEntry("user:1:name", "user:1:name".length.toLong())), entries)
+        val iterator = impl.keyEntries("order:", 1).iterator()
+        mmkv.removeValueForKey("order:1")
+        assertEquals(-1L, iterator.next().valueSize)
+        assertFalse(iterator.hasNext())
+    }
+
+    // 写后模式测试：入队后立即可读，flush 后落盘，多线程写入同一 key 只保留最新值
+    @Test
+    fun testWriteBehind() {
+        val impl = mmkv as MMKVImpl
+        impl.enableWriteBehind()
+        try {
+            repeat(1000) { mmkv["wbCounter"] = it }
+            assertEquals(999, mmkv.getInt("wbCounter"))
+            mmkv["wbString"] = "写后字符串"
+            mmkv["wbBytes"] = byteArrayOf(1, 2, 3)
+            mmkv.removeValueForKey("wbBytes")
+            assertFalse(mmkv.containsKey("wbBytes"))
+            assertEquals("写后字符串", mmkv.getString("wbString"))
+
+            val executor = Executors.newFixedThreadPool(4)
+            val latch = CountDownLatch(4)
+            repeat(4) { thread ->
+                executor.submit {
+                    repeat(500) { mmkv["wbThread_$thread"] = it.toLong() }
+                    latch.countDown()
+                }
+            }
+            assertTrue(latch.await(10, TimeUnit.SECONDS))
+            executor.shutdown()
+            assertTrue(impl.flush())
+            repeat(4) { assertEquals(499L, mmkv.getLong("wbThread_$it")) }
+        } finally {
+            impl.enableWriteBehind(false)
+        }
+        // 关闭后仍能读到写入的值，flush 直接返回 true
+        assertEquals(999, mmkv.getInt("wbCounter"))
+        assertTrue(impl.flush())
+    }
+
+    // Stats 计数与耗时直方图测试
+    @Test
+    fun testStats() {
+        val impl = mmkv as MMKVImpl
+        assertNull(impl.stats())
+        impl.enableStats()
+        try {
+            repeat(100) { mmkv["statsKey_$it"] = it }
+            repeat(50) { mmkv.getInt("statsKey_$it") }
+            mmkv.trim()
+
+            val stats = assertNotNull(impl.stats())
+            assertEquals(100, stats.writes)
+            assertEquals(50, stats.reads)
+            assertEquals(1, stats.trims)
+            assertTrue(stats.bytesAppended > 0)
+            assertEquals(100, stats.setLatency.sum())
+            assertEquals(50, stats.getLatency.sum())
+            assertTrue(stats.getLatencyPercentile(50.0) <= stats.getLatencyPercentile(99.0))
+
+            // 关闭后重新开启从零开始计数
+            impl.enableStats(false)
+            assertNull(impl.stats())
+            impl.enableStats()
+            assertEquals(0, assertNotNull(impl.stats()).writes)
+        } finally {
+            impl.enableStats(false)
+        }
+    }
+
     // 键存在性测试
     @Test
     fun testContainsKey() {
@@ -362,6 +655,304 @@ class MMKVImplTest {
         }
     }
 
+    // 并发预加载测试
+    @Test
+    fun testPreload() {
+        val ids = List(8) { "preloadMMKV_$it" }
+        val instances = preload(ids, threads = 4).map { it.get(30, TimeUnit.SECONDS) }
+        try {
+            instances.forEachIndexed { i, instance ->
+                assertEquals(ids[i], instance.mmapID())
+                instance["preloadKey"] = i
+                // 与 mmkvWithID 得到的是同一个实例
+                assertEquals(i, mmkvWithID(ids[i]).getInt("preloadKey"))
+            }
+            assertTrue(preload(emptyList()).isEmpty())
+        } finally {
+            instances.forEach {
+                it.clearAll()
+                it.close()
+            }
+        }
+    }
+
+    // 后台换密钥测试
+    @Test
+    fun testReKeyAsync() {
+        val reKeyId = "reKeyAsyncMMKV"
+        val encrypted = mmkvWithID(reKeyId, cryptKey = "oldKey") as MMKVImpl
+        try {
+            encrypted["reKeyString"] = "value"
+            encrypted["reKeyInt"] = 42
+
+            val stages = mutableListOf<MMKVReKeyStage>()
+            val future = encrypted.reKeyAsync("newKey") { synchronized(stages) { stages.add(it) } }
+            assertTrue(future.get(10, TimeUnit.SECONDS))
+            assertEquals(
+                listOf(MMKVReKeyStage.BACKED_UP, MMKVReKeyStage.REWRITTEN, MMKVReKeyStage.FINISHED),
+                synchronized(stages) { stages.toList() },
+            )
+            assertEquals("value", encrypted.takeString("reKeyString", ""))
+            assertEquals(42, encrypted.getInt("reKeyInt"))
+
+            // 多进程实例不支持
+            val multiProcessMMKV = mmkvWithID("reKeyAsyncMultiProcess", MMKVMode.MULTI_PROCESS) as MMKVImpl
+            assertFalse(multiProcessMMKV.reKeyAsync("newKey").get(10, TimeUnit.SECONDS))
+            multiProcessMMKV.close()
+        } finally {
+            encrypted.close()
+        }
+
+        // 以新密钥重新打开
+        val reopened = mmkvWithID(reKeyId, cryptKey = "newKey")
+        try {
+            assertEquals("value", reopened.takeString("reKeyString", ""))
+            assertEquals(42, reopened.getInt("reKeyInt"))
+        } finally {
+            reopened.clearAll()
+            reopened.close()
+        }
+    }
+
+    // 自动整理测试
+    @Test
+    fun testAutoCompaction() {
+        val compactionMMKV = mmkvWithID("autoCompactionMMKV") as MMKVImpl
+        try {
+            val keys = (0 until 1000).map { "compactionKey$it" }
+            keys.forEach { compactionMMKV[it] = ByteArray(1024) }
+            compactionMMKV["compactionKept"] = "kept"
+            val grownSize = compactionMMKV.totalSize
+
+            compactionMMKV.enableAutoCompaction(policy = MMKVCompactionPolicy(wasteRatio = 0.5, idleMillis = 50))
+            compactionMMKV.removeValuesForKeys(keys)
+
+            // 删除后文件大部分未使用，空闲后由后台线程收缩
+            val deadline = System.currentTimeMillis() + 5000
+            while (compactionMMKV.totalSize >= grownSize && System.currentTimeMillis() < deadline) {
+                Thread.sleep(20)
+            }
+            assertTrue(compactionMMKV.totalSize < grownSize)
+            assertEquals("kept", compactionMMKV.takeString("compactionKept", ""))
+
+            compactionMMKV.enableAutoCompaction(false)
+            assertFailsWith<IllegalArgumentException> { MMKVCompactionPolicy(wasteRatio = 2.0) }
+        } finally {
+            compactionMMKV.clearAll()
+            compactionMMKV.close()
+        }
+    }
+
+    // 原子读-改-写测试
+    @Test
+    fun testAtomicOperations() {
+        val impl = mmkv as MMKVImpl
+        assertEquals(15, impl.addAndGet("atomicInt", 5, default = 10))
+        assertEquals(12, impl.addAndGet("atomicInt", -3))
+        assertEquals(Long.MIN_VALUE, impl.addAndGet("atomicLong", 1L, default = Long.MAX_VALUE))
+
+        // 多线程并发累加不丢失更新
+        val executor = Executors.newFixedThreadPool(8)
+        repeat(8) {
+            executor.execute { repeat(1000) { impl.addAndGet("atomicCounter", 1L) } }
+        }
+        executor.shutdown()
+        assertTrue(executor.awaitTermination(30, TimeUnit.SECONDS))
+        assertEquals(8000L, impl.getLong("atomicCounter"))
+
+        // key 不存在时不写入
+        assertFalse(impl.compareAndSet("casMissing", 0, 1))
+        assertFalse(impl.containsKey("casMissing"))
+        impl["casInt"] = 1
+        assertFalse(impl.compareAndSet("casInt", 2, 3))
+        assertTrue(impl.compareAndSet("casInt", 1, 3))
+        assertEquals(3, impl.getInt("casInt"))
+        impl["casULong"] = ULong.MAX_VALUE
+        assertTrue(impl.compareAndSet("casULong", ULong.MAX_VALUE, 1uL))
+        assertEquals(1uL, impl.getULong("casULong"))
+        impl["casDouble"] = Double.NaN
+        assertTrue(impl.compareAndSet("casDouble", Double.NaN, 1.5))
+        assertEquals(1.5, impl.getDouble("casDouble"))
+        impl["casBoolean"] = false
+        assertTrue(impl.compareAndSet("casBoolean", false, true))
+        assertTrue(impl.getBoolean("casBoolean"))
+
+        // 合并计数：读取前先写入累积的增量
+        impl.enableMergedCounters(flushMillis = 60_000)
+        try {
+            repeat(100) { impl.addMerged("mergedCounter", 2L) }
+            assertEquals(200L, impl.getLong("mergedCounter"))
+            impl.addMerged("mergedCounter", 1L)
+        } finally {
+            impl.enableMergedCounters(false)
+        }
+        assertEquals(201L, impl.getLong("mergedCounter"))
+    }
+
+    // 事务测试
+    @Test
+    fun testTransaction() {
+        val impl = mmkv as MMKVImpl
+        impl["txnStale"] = "stale"
+        assertTrue(impl.transaction {
+            this["txnToken"] = "token"
+            this["txnExpiry"] = 1_700_000_000_000L
+            this["txnScope"] = 3
+            this["txnBytes"] = byteArrayOf(1, 2, 3)
+            removeValueForKey("txnStale")
+            // 块内读取仍为提交前的值
+            assertFalse(impl.containsKey("txnToken"))
+        })
+        assertEquals("token", impl.takeString("txnToken", ""))
+        assertEquals(1_700_000_000_000L, impl.getLong("txnExpiry"))
+        assertEquals(3, impl.getInt("txnScope"))
+        assertContentEquals(byteArrayOf(1, 2, 3), impl.getByteArray("txnBytes"))
+        assertFalse(impl.containsKey("txnStale"))
+
+        // 块内抛出异常时不写入任何修改
+        assertFailsWith<IllegalStateException> {
+            impl.transaction {
+                this["txnToken"] = "other"
+                error("abort")
+            }
+        }
+        assertEquals("token", impl.takeString("txnToken", ""))
+
+        // 加密实例
+        val encrypted = mmkvWithID("transactionEncrypted", cryptKey = "txnKey") as MMKVImpl
+        try {
+            assertTrue(encrypted.transaction { this["txnEncrypted"] = "secret" })
+            assertEquals("secret", encrypted.takeString("txnEncrypted", ""))
+        } finally {
+            encrypted.clearAll()
+            encrypted.close()
+        }
+    }
+
+    // 变更通知测试
+    @Test
+    fun testChangeNotifications() = runBlocking {
+        val impl = mmkv as MMKVImpl
+        assertTrue(impl.enableChangeNotify())
+        try {
+            val received = Channel<String?>(Channel.UNLIMITED)
+            val collector = launch(Dispatchers.IO) {
+                impl.changes("feed.").collect { received.send(it) }
+            }
+            // 订阅在收集开始后才生效，写入直到收到第一个通知
+            val first = withTimeout(5_000) {
+                var change: String? = null
+                while (change == null) {
+                    impl["feed.ready"] = true
+                    change = withTimeoutOrNull(50) { received.receive() }
+                }
+                change
+            }
+            assertEquals("feed.ready", first)
+            while (received.tryReceive().isSuccess) Unit
+
+            impl["other.key"] = 1
+            impl["feed.count"] = 2
+            assertEquals("feed.count", withTimeout(5_000) { received.receive() })
+
+            // clearAll 无法确定具体 key
+            impl.clearAll()
+            assertNull(withTimeout(5_000) { received.receive() })
+            collector.cancelAndJoin()
+        } finally {
+            impl.enableChangeNotify(false)
+        }
+    }
+
+    // 分片实例测试
+    @Test
+    fun testShardedStore() {
+        val id = "shardedStore"
+        val sharded = shardedMMKV(id, shardCount = 4)
+        try {
+            repeat(200) { sharded["key$it"] = it }
+            sharded["name"] = "sharded"
+            assertTrue(sharded.setAll(mapOf("a" to 1L, "b" to 2.0, "c" to null)))
+            assertEquals(199, sharded.getInt("key199"))
+            assertEquals("sharded", sharded.getString("name"))
+            assertEquals(203L, sharded.count)
+            assertEquals(203, sharded.allKeys().toSet().size)
+            assertEquals(200, sharded.keys("key").count())
+            assertEquals(mapOf("a" to 1L, "key7" to 7), sharded.getAll(mapOf("a" to 0L, "key7" to 0)))
+            sharded.removeValuesForKeys(List(100) { "key$it" })
+            assertEquals(103L, sharded.count)
+            sharded.trim()
+            sharded.close()
+
+            // 分片数与记录的不一致时拒绝打开
+            assertFailsWith<IllegalStateException> { shardedMMKV(id, shardCount = 2) }
+
+            reshardMMKV(id, shardCount = 3)
+            val resharded = shardedMMKV(id, shardCount = 3)
+            assertEquals(103L, resharded.count)
+            assertEquals(150, resharded.getInt("key150"))
+            assertEquals(2.0, resharded.getDouble("b"))
+            assertFalse(resharded.containsKey("key50"))
+            resharded.clearAll()
+            resharded.close()
+        } finally {
+            reshardMMKV(id, shardCount = 4)
+        }
+    }
+
+    // 内存预算测试
+    @Test
+    fun testMemoryBudget() {
+        val instances = List(3) { mmkvWithID("memoryBudget$it") }
+        try {
+            instances.forEachIndexed { index, instance -> instance["value"] = "instance$index" }
+            val before = memoryBudgetState().evictions
+            // 预算极小时所有空闲实例都会被释放
+            setMemoryBudget(budgetBytes = 1, idleMillis = 0)
+            enforceMemoryBudget()
+            val state = memoryBudgetState()
+            assertEquals(1, state.budgetBytes)
+            assertTrue(state.evictions >= before + instances.size)
+            assertTrue(state.residentInstances < state.instances)
+
+            // 被释放的实例在下次访问时重新加载
+            instances.forEachIndexed { index, instance ->
+                assertEquals("instance$index", instance.getString("value"))
+            }
+        } finally {
+            setMemoryBudget(0)
+            instances.forEach {
+                it.clearAll()
+                it.close()
+            }
+        }
+        assertEquals(0, memoryBudgetState().budgetBytes)
+    }
+
+    // 只写不读的实例测试
+    @Test
+    fun testMemoryBudgetWriteOnly() {
+        val instance = mmkvWithID("memoryBudgetWriteOnly")
+        try {
+            setMemoryBudget(budgetBytes = 1, idleMillis = 500)
+            Thread.sleep(600)
+            // 先释放所有已空闲的实例，包括 instance
+            enforceMemoryBudget()
+            val idle = memoryBudgetState()
+
+            // 写入同样算作访问，实例恢复为常驻且不再被视为空闲
+            instance["value"] = 1
+            val written = memoryBudgetState()
+            assertTrue(written.residentInstances > idle.residentInstances)
+            enforceMemoryBudget()
+            assertEquals(written.evictions, memoryBudgetState().evictions)
+        } finally {
+            setMemoryBudget(0)
+            instance.clearAll()
+            instance.close()
+        }
+    }
+
     // 同步操作测试
     @Test
     fun testSync() {